@@ -0,0 +1,110 @@
+//! Benchmarks of the board operations the solver is built on
+//!
+//! Every benchmark runs over all of the boards of a sample set, so the time reported is for the
+//! whole set. Divide by the number of boards (or placed values for `place`) to get the time of a
+//! single operation.
+
+#[macro_use]
+extern crate criterion;
+
+extern crate sudoku;
+
+use std::io::{self, Cursor};
+use std::num::NonZeroU8;
+
+use criterion::{Criterion, black_box};
+use sudoku::{Sudoku, Pos, ReadError};
+
+criterion_main!(primitives);
+
+macro_rules! primitive_bench_group {
+    ($($name:ident, $file:expr;)*) => {
+        criterion_group! {
+            name = primitives;
+            config = Criterion::default().sample_size(20).noise_threshold(0.025);
+            targets = $($name),*
+        }
+
+        $(
+            fn $name(c: &mut Criterion) {
+                // Every value of every board, so placing them rebuilds the boards from scratch
+                let boards: Vec<_> = read_all_boards(include_bytes!($file)).collect();
+                let values: Vec<Vec<(Pos, NonZeroU8)>> = boards.iter().map(board_values).collect();
+
+                c.bench_function(concat!(stringify!($name), "_place"), move |b| b.iter_with_setup(
+                    || vec![Sudoku::default(); values.len()],
+                    |mut empty| {
+                        for (board, values) in empty.iter_mut().zip(&values) {
+                            for &(pos, value) in values {
+                                board.place(pos, value);
+                            }
+                        }
+                        empty
+                    },
+                ));
+
+                let clone_boards = boards.clone();
+                c.bench_function(concat!(stringify!($name), "_clone"), move |b| b.iter(|| {
+                    clone_boards.iter().map(|board| black_box(board.clone())).count()
+                }));
+
+                c.bench_function(concat!(stringify!($name), "_min_possible_empty_tile"), move |b| b.iter(|| {
+                    boards.iter().map(|board| black_box(board.min_possible_empty_tile()).is_ok()).count()
+                }));
+
+                // Reading every board of the file, byte by byte and with the buffered reader
+                let text: &'static [u8] = include_bytes!($file);
+                c.bench_function(concat!(stringify!($name), "_read_board"), move |b| b.iter(|| {
+                    read_all_boards(text).map(black_box).count()
+                }));
+
+                c.bench_function(concat!(stringify!($name), "_board_reader"), move |b| b.iter(|| {
+                    let mut reader = sudoku::BoardReader::new(Cursor::new(text));
+                    let mut count = 0;
+                    while let Some(board) = reader.read_board().expect("Error reading sudoku board") {
+                        black_box(board);
+                        count += 1;
+                    }
+                    count
+                }));
+            }
+        )*
+    };
+}
+
+primitive_bench_group! {
+    easy, "../samples/easy.txt";
+    hard95, "../samples/hard95.txt";
+}
+
+/// Returns the position and value of every tile of the board that is not empty
+fn board_values(board: &Sudoku) -> Vec<(Pos, NonZeroU8)> {
+    // Display writes one row of digits per line, which is simpler than reaching into the tiles
+    board.to_string().lines().enumerate().flat_map(|(row, line)| {
+        line.bytes().enumerate().filter_map(move |(col, digit)| {
+            NonZeroU8::new(digit - b'0').map(|value| (Pos {row, col}, value))
+        }).collect::<Vec<_>>()
+    }).collect()
+}
+
+fn read_all_boards(data: &'static [u8]) -> impl Iterator<Item=Sudoku> {
+    // FIXME: Eventually when Rust supports `yield`, this could be rewritten without the extra struct
+    let reader = Cursor::new(data);
+    BoardReader {reader}
+}
+
+struct BoardReader<'a> {
+    reader: Cursor<&'a [u8]>,
+}
+
+impl<'a> Iterator for BoardReader<'a> {
+    type Item = Sudoku;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        match Sudoku::read_board(&mut self.reader) {
+            Ok(board) => Ok(Some(board)),
+            Err(ReadError::IOError(ref err)) if err.kind() == io::ErrorKind::UnexpectedEof => Ok(None),
+            Err(err) => Err(err),
+        }.expect("Error reading sudoku board")
+    }
+}
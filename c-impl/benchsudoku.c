@@ -0,0 +1,464 @@
+/**
+ * Microbenchmarks for the board primitives the solver is built on
+ *
+ * Reads boards from stdin (one of the sample sets gives stable inputs) and
+ * times every primitive over them. The boards are repeated until there are
+ * at least BENCH_BOARDS of them so that every measurement covers enough
+ * operations to be larger than the cost of measuring. Only the work being
+ * benchmarked is measured: preparing fresh boards for it is not.
+ *
+ * Every benchmark runs for a number of rounds and reports the nanoseconds
+ * and instructions per operation of the fastest round and the median round.
+ * Instructions are counted with perf_event_open where it is available (on
+ * Linux, if perf events are allowed) and reported as "-" otherwise. The
+ * cost of measuring an empty stretch of code is subtracted from both.
+ *
+ * Usage: benchsudoku [--rounds n] < input
+ */
+
+// From: http://stackoverflow.com/a/3875233/551904
+// Used to prevent `storage size of start isn't known` error
+#if __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 600
+#else
+#define _XOPEN_SOURCE 500
+#endif /* __STDC_VERSION__ */
+// syscall (used for perf_event_open) is not part of POSIX
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h> // atoi, malloc, qsort, exit, EXIT_FAILURE, EXIT_SUCCESS
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "sudoku.h"
+#include "boardparser.h"
+#include "boardreader.h"
+#include "drawboard.h"
+
+// The solver is compiled into this program so that its static helpers
+// (simpleSolver and minimumTile) can be timed exactly as the solver runs
+// them
+#include "puzzlesolver.c"
+
+// The input is repeated until there are at least this many boards. Few
+// enough that the boards stay in the cache like the boards of a search do.
+#define BENCH_BOARDS 256
+#define DEFAULT_ROUNDS 25
+
+typedef struct {
+    double nanoseconds;
+    // -1 if instructions are not counted
+    long long instructions;
+} Measurement;
+
+typedef struct {
+    const char* name;
+    // Runs the benchmark once over every board, adding what it measured to
+    // measurement. Returns the number of operations that were measured.
+    long (*run)(Measurement*);
+} Benchmark;
+
+// The boards as read, the same boards after simple solving (the boards the
+// search picks tiles to guess on) and room for fresh copies of them
+static SudokuBoard* boards;
+static SudokuBoard* searchBoards;
+static SudokuBoard* scratch;
+static int boardCount;
+static int searchBoardCount;
+// The text of every board, read back by the readBoard benchmark
+static FILE* boardText;
+
+// Results are added up here so that the benchmarked calls are not
+// optimized away
+static volatile long sink;
+
+static int instructionCounter = -1;
+static Measurement overhead;
+static struct timespec windowStart;
+static long long windowInstructions;
+
+static void* allocate(size_t size) {
+    void* memory = malloc(size);
+    if (memory == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+/**
+ * Starts counting the instructions of this thread if perf events are
+ * available. Instructions are not counted otherwise.
+ */
+static void openInstructionCounter(void) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    int fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd == -1) {
+        return;
+    }
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    instructionCounter = fd;
+#endif
+}
+
+static long long readInstructionCounter(void) {
+    long long count = -1;
+#ifdef __linux__
+    if (instructionCounter != -1 && read(instructionCounter, &count, sizeof(count)) != sizeof(count)) {
+        count = -1;
+    }
+#endif
+    return count;
+}
+
+static void startWindow(void) {
+    windowInstructions = readInstructionCounter();
+    clock_gettime(CLOCK_MONOTONIC, &windowStart);
+}
+
+/**
+ * Adds what was measured since startWindow (minus the cost of measuring)
+ * to measurement
+ */
+static void stopWindow(Measurement* measurement) {
+    struct timespec stop;
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    long long instructions = readInstructionCounter();
+
+    measurement->nanoseconds += (stop.tv_sec - windowStart.tv_sec) * BILLION
+        + (stop.tv_nsec - windowStart.tv_nsec) - overhead.nanoseconds;
+    if (instructions == -1 || windowInstructions == -1) {
+        measurement->instructions = -1;
+    }
+    else if (measurement->instructions != -1) {
+        measurement->instructions += instructions - windowInstructions - overhead.instructions;
+    }
+}
+
+/**
+ * Measures the cost of measuring: the cheapest of many empty windows
+ */
+static void calibrateOverhead(void) {
+    Measurement cheapest = {1e18, 0};
+    for (int i = 0; i < 1000; i++) {
+        Measurement empty = {0, 0};
+        startWindow();
+        stopWindow(&empty);
+        if (empty.nanoseconds < cheapest.nanoseconds) {
+            cheapest = empty;
+        }
+    }
+    overhead = cheapest;
+}
+
+static long benchPlace(Measurement* measurement) {
+    for (int i = 0; i < boardCount; i++) {
+        emptySudokuBoard(&scratch[i]);
+    }
+
+    long placed = 0;
+    startWindow();
+    for (int i = 0; i < boardCount; i++) {
+        for (int index = 0; index < BOARD_CELLS; index++) {
+            short value = boards[i].tiles[index].value;
+            if (value != 0) {
+                placeSudokuValue(&scratch[i], index / BOARD_SIZE, index % BOARD_SIZE, value);
+                placed++;
+            }
+        }
+    }
+    stopWindow(measurement);
+    return placed;
+}
+
+static long benchCopy(Measurement* measurement) {
+    startWindow();
+    for (int i = 0; i < boardCount; i++) {
+        copySudokuBoard(&boards[i], &scratch[i]);
+    }
+    stopWindow(measurement);
+    return boardCount;
+}
+
+static long runMinimumTile(Measurement* measurement, const SolverOptions* options) {
+    // Set up like solveBoardWithOptions does, by field name so that the
+    // state keeps matching its struct
+    SolverStats stats = {0};
+    struct SearchState state = {.maxSolutions = 1, .options = options, .stats = &stats,
+        .random = 0x9e3779b97f4a7c15ull};
+
+    long total = 0;
+    startWindow();
+    for (int i = 0; i < searchBoardCount; i++) {
+        total += minimumTile(&searchBoards[i], &state);
+    }
+    stopWindow(measurement);
+    sink += total;
+    return searchBoardCount;
+}
+
+static long benchMinimumTile(Measurement* measurement) {
+    return runMinimumTile(measurement, &defaultSolverOptions);
+}
+
+static long benchMinimumTileFirst(Measurement* measurement) {
+    SolverOptions options = defaultSolverOptions;
+    options.degreeTieBreak = false;
+    return runMinimumTile(measurement, &options);
+}
+
+static long benchSimpleSolver(Measurement* measurement) {
+    for (int i = 0; i < boardCount; i++) {
+        copySudokuBoard(&boards[i], &scratch[i]);
+    }
+
+    long total = 0;
+    startWindow();
+    for (int i = 0; i < boardCount; i++) {
+        total += simpleSolver(&scratch[i]);
+    }
+    stopWindow(measurement);
+    sink += total;
+    return boardCount;
+}
+
+static long benchReadBoard(Measurement* measurement) {
+    rewind(boardText);
+
+    long total = 0;
+    startWindow();
+    for (int i = 0; i < boardCount; i++) {
+        total += readBoard(boardText, &scratch[i]);
+    }
+    stopWindow(measurement);
+    sink += total;
+    return boardCount;
+}
+
+static long benchReadBoardValues(Measurement* measurement) {
+    rewind(boardText);
+    BoardReader* reader = createBoardReader(boardText);
+    if (reader == NULL) {
+        fprintf(stderr, "Unable to allocate the input buffer\n");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned char values[BOARD_CELLS];
+    long total = 0;
+    startWindow();
+    for (int i = 0; i < boardCount; i++) {
+        total += readBoardValues(reader, values);
+        total += values[i % BOARD_CELLS];
+    }
+    stopWindow(measurement);
+    freeBoardReader(reader);
+    sink += total;
+    return boardCount;
+}
+
+static long benchReadNextBoard(Measurement* measurement) {
+    rewind(boardText);
+    BoardReader* reader = createBoardReader(boardText);
+    if (reader == NULL) {
+        fprintf(stderr, "Unable to allocate the input buffer\n");
+        exit(EXIT_FAILURE);
+    }
+
+    long total = 0;
+    startWindow();
+    for (int i = 0; i < boardCount; i++) {
+        total += readNextBoard(reader, &scratch[i]);
+    }
+    stopWindow(measurement);
+    freeBoardReader(reader);
+    sink += total;
+    return boardCount;
+}
+
+static long benchIsValidBoard(Measurement* measurement) {
+    long total = 0;
+    startWindow();
+    for (int i = 0; i < boardCount; i++) {
+        total += isValidBoard(&boards[i]);
+    }
+    stopWindow(measurement);
+    sink += total;
+    return boardCount;
+}
+
+static const Benchmark benchmarks[] = {
+    {"placeSudokuValue", benchPlace},
+    {"copySudokuBoard", benchCopy},
+    {"minimumTile", benchMinimumTile},
+    {"minimumTile (first)", benchMinimumTileFirst},
+    {"simpleSolver", benchSimpleSolver},
+    {"readBoard", benchReadBoard},
+    {"readBoardValues", benchReadBoardValues},
+    {"readNextBoard", benchReadNextBoard},
+    {"isValidBoard", benchIsValidBoard},
+};
+
+/**
+ * Reads every board from fp and repeats them until there are at least
+ * BENCH_BOARDS. Also prepares the boards the other benchmarks start from.
+ *
+ * Returns 0 if successful, -1 if there were no boards
+ */
+static int readBenchBoards(FILE* fp) {
+    int capacity = 64;
+    int count = 0;
+    SudokuBoard* read = allocate(capacity * sizeof(SudokuBoard));
+    while (true) {
+        if (count == capacity) {
+            capacity *= 2;
+            read = realloc(read, capacity * sizeof(SudokuBoard));
+            if (read == NULL) {
+                perror("realloc");
+                exit(EXIT_FAILURE);
+            }
+        }
+        if (readBoard(fp, &read[count]) == -1) {
+            break;
+        }
+        if (isValidBoard(&read[count])) {
+            count++;
+        }
+    }
+    if (count == 0) {
+        free(read);
+        return -1;
+    }
+
+    boardCount = count < BENCH_BOARDS ? ((BENCH_BOARDS + count - 1) / count) * count : count;
+    boards = allocate(boardCount * sizeof(SudokuBoard));
+    searchBoards = allocate(boardCount * sizeof(SudokuBoard));
+    scratch = allocate(boardCount * sizeof(SudokuBoard));
+    for (int i = 0; i < boardCount; i++) {
+        copySudokuBoard(&read[i % count], &boards[i]);
+    }
+    free(read);
+
+    // minimumTile is only called on boards that simple solving got stuck on
+    searchBoardCount = 0;
+    for (int i = 0; i < boardCount; i++) {
+        SudokuBoard* board = &searchBoards[searchBoardCount];
+        copySudokuBoard(&boards[i], board);
+        if (simpleSolver(board) == 0 && board->emptyCount > 0) {
+            searchBoardCount++;
+        }
+    }
+    if (searchBoardCount == 0) {
+        // Every board was solved without guessing, so time the boards as read
+        searchBoardCount = boardCount;
+        for (int i = 0; i < boardCount; i++) {
+            copySudokuBoard(&boards[i], &searchBoards[i]);
+        }
+    }
+
+    boardText = tmpfile();
+    if (boardText == NULL) {
+        perror("tmpfile");
+        exit(EXIT_FAILURE);
+    }
+    char text[BOARD_TEXT_SIZE + 1];
+    for (int i = 0; i < boardCount; i++) {
+        int length = formatSudokuBoardSimple(&boards[i], text);
+        fwrite(text, 1, length, boardText);
+    }
+    return 0;
+}
+
+static int compareMeasurements(const void* a, const void* b) {
+    double difference = ((const Measurement*) a)->nanoseconds - ((const Measurement*) b)->nanoseconds;
+    return (difference > 0) - (difference < 0);
+}
+
+static void printPerOperation(const Measurement* measurement, long operations) {
+    printf("%14.2f", measurement->nanoseconds / operations);
+    if (measurement->instructions == -1) {
+        printf("%16s", "-");
+    }
+    else {
+        printf("%16.1f", (double) measurement->instructions / operations);
+    }
+}
+
+/**
+ * Runs a benchmark for the given number of rounds and prints the fastest
+ * and the median round
+ */
+static void runBenchmark(const Benchmark* benchmark, int rounds) {
+    Measurement* measurements = allocate(rounds * sizeof(Measurement));
+    long operations = 0;
+    // One round that is not counted warms up the caches
+    Measurement warmup = {0, 0};
+    benchmark->run(&warmup);
+    for (int round = 0; round < rounds; round++) {
+        measurements[round] = (Measurement) {0, 0};
+        operations = benchmark->run(&measurements[round]);
+    }
+    qsort(measurements, rounds, sizeof(Measurement), compareMeasurements);
+
+    printf("%-22s%10ld", benchmark->name, operations);
+    printPerOperation(&measurements[0], operations);
+    printPerOperation(&measurements[rounds / 2], operations);
+    printf("\n");
+    free(measurements);
+}
+
+static void printUsage(char* program) {
+    fprintf(stderr, "Usage: %s [--rounds n] < input\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    int rounds = DEFAULT_ROUNDS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+            if (rounds <= 0) {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (readBenchBoards(stdin) == -1) {
+        fprintf(stderr, "No valid boards were read\n");
+        return EXIT_FAILURE;
+    }
+
+    openInstructionCounter();
+    if (instructionCounter == -1) {
+        fprintf(stderr, "Instructions are not counted: perf events are not available\n");
+    }
+    calibrateOverhead();
+
+    printf("%-22s%10s%14s%16s%14s%16s\n", "benchmark", "ops/round",
+        "best ns/op", "best instr/op", "median ns/op", "median instr/op");
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+        runBenchmark(&benchmarks[i], rounds);
+    }
+
+    return EXIT_SUCCESS;
+}
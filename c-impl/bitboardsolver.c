@@ -0,0 +1,438 @@
+/**
+ * A solver for 9x9 boards that stores candidates as bitboards
+ *
+ * Every digit has a plane with one bit per tile that is set if the digit can
+ * still be placed on that tile (or already has been). Each plane is split
+ * into three bands of 27 bits, one for every band of three rows, so a whole
+ * band of a plane fits in a single 32 bit word. Tile (row_i, col_i) is bit
+ * (row_i % 3) * 9 + col_i of band row_i / 3.
+ *
+ * Placing values, finding naked and hidden singles and box-line
+ * interactions (locked candidates) all work on whole bands at once with
+ * bitwise operations instead of going through tiles one by one.
+ */
+#include <stdlib.h> // NULL
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+#include "bitboardsolver.h"
+
+#define BANDS 3
+// Every tile of a band
+#define FULL_BAND 0x7FFFFFFu
+// The first row, column and box of a band
+#define ROW_MASK 0x1FFu
+#define COLUMN_MASK 0x40201u
+#define BOX_MASK 0x1C0E07u
+
+typedef struct {
+    // The tiles where each digit (0 to 8) can still go, per band
+    uint32_t planes[BOARD_SIZE][BANDS];
+    // The tiles that do not have a value yet, per band
+    uint32_t unsolved[BANDS];
+} Bitboard;
+
+static inline int bitCount(uint32_t bits) {
+    return __builtin_popcount(bits);
+}
+
+/**
+ * Places digit on the given tile of a band, removing it from every tile in
+ * the same row, column and box and every other digit from the tile
+ *
+ * Returns -1 if the digit could not be placed on the tile, 0 otherwise
+ */
+static int placeDigit(Bitboard* board, int digit, int band, int bit) {
+    uint32_t tile = 1u << bit;
+    if (!(board->planes[digit][band] & tile)) {
+        return -1;
+    }
+
+    int row = bit / 9;
+    int col = bit % 9;
+    for (int b = 0; b < BANDS; b++) {
+        board->planes[digit][b] &= ~(COLUMN_MASK << col);
+    }
+    board->planes[digit][band] &= ~((ROW_MASK << (row * 9)) | (BOX_MASK << (col / 3 * 3)));
+    board->planes[digit][band] |= tile;
+
+    for (int d = 0; d < BOARD_SIZE; d++) {
+        if (d != digit) {
+            board->planes[d][band] &= ~tile;
+        }
+    }
+
+    board->unsolved[band] &= ~tile;
+    return 0;
+}
+
+/**
+ * Counts the digits that can go on every tile of a band, saturating at
+ * three: tiles with at least one digit are set in ones, tiles with at least
+ * two in twos and tiles with at least three in threes
+ */
+static void countDigits(const Bitboard* board, int band,
+        uint32_t* ones, uint32_t* twos, uint32_t* threes) {
+    *ones = 0;
+    *twos = 0;
+    *threes = 0;
+    for (int d = 0; d < BOARD_SIZE; d++) {
+        uint32_t plane = board->planes[d][band];
+        *threes |= *twos & plane;
+        *twos |= *ones & plane;
+        *ones |= plane;
+    }
+}
+
+/**
+ * Places every unsolved tile that only has a single digit left
+ *
+ * Returns the number of values placed, -1 if the board is a dead end
+ */
+static int nakedSingles(Bitboard* board) {
+    int placed = 0;
+    for (int band = 0; band < BANDS; band++) {
+        uint32_t ones, twos, threes;
+        countDigits(board, band, &ones, &twos, &threes);
+
+        uint32_t unsolved = board->unsolved[band];
+        if (unsolved & ~ones) {
+            // A tile without any digits left
+            return -1;
+        }
+
+        uint32_t singles = unsolved & ~twos;
+        while (singles != 0) {
+            int bit = __builtin_ctz(singles);
+            singles &= singles - 1;
+
+            // Placing an earlier single may have taken the last digit
+            int digit = 0;
+            while (digit < BOARD_SIZE && !(board->planes[digit][band] & (1u << bit))) {
+                digit++;
+            }
+            if (digit == BOARD_SIZE) {
+                return -1;
+            }
+
+            placeDigit(board, digit, band, bit);
+            placed++;
+        }
+    }
+    return placed;
+}
+
+/**
+ * Checks a single unit (given as its tiles in one band) of a digit's plane
+ * Places the digit if there is only one unsolved tile left for it
+ *
+ * Returns 1 if the digit was placed, 0 if not and -1 if the digit can no
+ * longer go anywhere in the unit
+ */
+static int hiddenSingleInBand(Bitboard* board, int digit, int band, uint32_t unit) {
+    uint32_t tiles = board->planes[digit][band] & unit;
+    if (tiles == 0) {
+        return -1;
+    }
+    if ((tiles & (tiles - 1)) == 0 && (tiles & board->unsolved[band])) {
+        placeDigit(board, digit, band, __builtin_ctz(tiles));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Places every digit that can only go on one tile of a row, column or box
+ *
+ * Returns the number of values placed, -1 if the board is a dead end
+ */
+static int hiddenSingles(Bitboard* board) {
+    int placed = 0;
+    for (int digit = 0; digit < BOARD_SIZE; digit++) {
+        for (int band = 0; band < BANDS; band++) {
+            for (int i = 0; i < 3; i++) {
+                int rowResult = hiddenSingleInBand(board, digit, band, ROW_MASK << (i * 9));
+                int boxResult = hiddenSingleInBand(board, digit, band, BOX_MASK << (i * 3));
+                if (rowResult == -1 || boxResult == -1) {
+                    return -1;
+                }
+                placed += rowResult + boxResult;
+            }
+        }
+
+        // Columns cross every band
+        uint32_t* planes = board->planes[digit];
+        for (int col = 0; col < BOARD_SIZE; col++) {
+            uint32_t column = COLUMN_MASK << col;
+            int count = bitCount(planes[0] & column) + bitCount(planes[1] & column)
+                + bitCount(planes[2] & column);
+            if (count == 0) {
+                return -1;
+            }
+            if (count != 1) {
+                continue;
+            }
+
+            for (int band = 0; band < BANDS; band++) {
+                uint32_t tile = planes[band] & column;
+                if (tile & board->unsolved[band]) {
+                    placeDigit(board, digit, band, __builtin_ctz(tile));
+                    placed++;
+                }
+            }
+        }
+    }
+    return placed;
+}
+
+/**
+ * Removes digits using box-line interactions: if a digit can only go in one
+ * box within a row (or column), it cannot go anywhere else in that box and
+ * if it can only go in one row (or column) within a box, it cannot go
+ * anywhere else in that row (or column)
+ *
+ * Returns true if any digit was removed
+ */
+static bool lockedCandidates(Bitboard* board) {
+    bool changed = false;
+    for (int digit = 0; digit < BOARD_SIZE; digit++) {
+        uint32_t* planes = board->planes[digit];
+
+        // Rows and boxes share a band
+        for (int band = 0; band < BANDS; band++) {
+            uint32_t plane = planes[band];
+            for (int row = 0; row < 3; row++) {
+                uint32_t rowMask = ROW_MASK << (row * 9);
+                for (int box = 0; box < 3; box++) {
+                    uint32_t boxMask = BOX_MASK << (box * 3);
+                    uint32_t inRow = plane & rowMask;
+                    if (inRow != 0 && (inRow & ~boxMask) == 0) {
+                        plane &= ~(boxMask & ~rowMask);
+                    }
+                    uint32_t inBox = plane & boxMask;
+                    if (inBox != 0 && (inBox & ~rowMask) == 0) {
+                        plane &= ~(rowMask & ~boxMask);
+                    }
+                }
+            }
+            if (plane != planes[band]) {
+                planes[band] = plane;
+                changed = true;
+            }
+        }
+
+        // Columns cross the bands, so work on the columns each band has the
+        // digit in
+        uint32_t columns[BANDS];
+        for (int band = 0; band < BANDS; band++) {
+            uint32_t plane = planes[band];
+            columns[band] = (plane | plane >> 9 | plane >> 18) & ROW_MASK;
+        }
+
+        for (int band = 0; band < BANDS; band++) {
+            for (int box = 0; box < 3; box++) {
+                uint32_t inBox = columns[band] & (7u << (box * 3));
+                if (inBox == 0 || (inBox & (inBox - 1)) != 0) {
+                    continue;
+                }
+                // Only one column of this box, so not in that column of the
+                // other bands
+                uint32_t column = COLUMN_MASK << __builtin_ctz(inBox);
+                for (int other = 0; other < BANDS; other++) {
+                    if (other != band && (planes[other] & column)) {
+                        planes[other] &= ~column;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        for (int col = 0; col < BOARD_SIZE; col++) {
+            uint32_t bit = 1u << col;
+            int band;
+            if ((columns[0] & bit) && !((columns[1] | columns[2]) & bit)) {
+                band = 0;
+            }
+            else if ((columns[1] & bit) && !((columns[0] | columns[2]) & bit)) {
+                band = 1;
+            }
+            else if ((columns[2] & bit) && !((columns[0] | columns[1]) & bit)) {
+                band = 2;
+            }
+            else {
+                continue;
+            }
+            // Only one band of this column, so not in the rest of that box
+            uint32_t others = (BOX_MASK << (col / 3 * 3)) & ~(COLUMN_MASK << col);
+            if (planes[band] & others) {
+                planes[band] &= ~others;
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+/**
+ * Applies every technique until none of them make any more progress
+ *
+ * Returns -1 if the board turned out to be a dead end, 0 otherwise
+ */
+static int propagate(Bitboard* board) {
+    while (true) {
+        int placed = nakedSingles(board);
+        if (placed == -1) {
+            return -1;
+        }
+        if (placed > 0) {
+            continue;
+        }
+
+        placed = hiddenSingles(board);
+        if (placed == -1) {
+            return -1;
+        }
+        if (placed > 0) {
+            continue;
+        }
+
+        if (!lockedCandidates(board)) {
+            return 0;
+        }
+    }
+}
+
+/**
+ * Picks the unsolved tile with the fewest digits left to guess on
+ * Tiles with two digits are found for a whole band at once, which is
+ * usually enough. Otherwise the digits of every tile are counted.
+ */
+static void chooseTile(const Bitboard* board, int* tileBand, int* tileBit) {
+    for (int band = 0; band < BANDS; band++) {
+        uint32_t ones, twos, threes;
+        countDigits(board, band, &ones, &twos, &threes);
+        uint32_t pairs = board->unsolved[band] & twos & ~threes;
+        if (pairs != 0) {
+            *tileBand = band;
+            *tileBit = __builtin_ctz(pairs);
+            return;
+        }
+    }
+
+    int minCount = BOARD_SIZE + 1;
+    for (int band = 0; band < BANDS; band++) {
+        uint32_t unsolved = board->unsolved[band];
+        while (unsolved != 0) {
+            int bit = __builtin_ctz(unsolved);
+            unsolved &= unsolved - 1;
+
+            int count = 0;
+            for (int digit = 0; digit < BOARD_SIZE; digit++) {
+                count += (board->planes[digit][band] >> bit) & 1;
+            }
+            if (count < minCount) {
+                minCount = count;
+                *tileBand = band;
+                *tileBit = bit;
+            }
+        }
+    }
+}
+
+/**
+ * Solves the board as far as possible and then guesses
+ *
+ * Returns 0 with the solution left on the board if one was found, -1
+ * otherwise
+ */
+static int search(Bitboard* board, SolverStats* stats) {
+    if (propagate(board) == -1) {
+        return -1;
+    }
+
+    if ((board->unsolved[0] | board->unsolved[1] | board->unsolved[2]) == 0) {
+        return 0;
+    }
+
+    int band = 0;
+    int bit = 0;
+    chooseTile(board, &band, &bit);
+    uint32_t tile = 1u << bit;
+
+    Bitboard copy;
+    for (int digit = 0; digit < BOARD_SIZE; digit++) {
+        if (!(board->planes[digit][band] & tile)) {
+            continue;
+        }
+
+        copy = *board;
+        placeDigit(&copy, digit, band, bit);
+        stats->guesses++;
+
+        if (search(&copy, stats) == 0) {
+            *board = copy;
+            return 0;
+        }
+
+        // The guess was wrong, which may leave the tile with only one digit
+        // that the next guess places without copying
+        board->planes[digit][band] &= ~tile;
+    }
+
+    return -1;
+}
+
+/**
+ * Solves a 9x9 board with the bitboard engine
+ * options are not used. stats (if not NULL) is filled with the statistics
+ * of the search.
+ *
+ * Returns 0 if solving was successful, -1 otherwise
+ */
+int solveBoardBitboard(SudokuBoard* board, const SolverOptions* options, SolverStats* stats) {
+    SolverStats localStats;
+    if (stats == NULL) {
+        stats = &localStats;
+    }
+    *stats = (SolverStats) {0};
+
+    Bitboard bitboard;
+    for (int band = 0; band < BANDS; band++) {
+        for (int digit = 0; digit < BOARD_SIZE; digit++) {
+            bitboard.planes[digit][band] = FULL_BAND;
+        }
+        bitboard.unsolved[band] = FULL_BAND;
+    }
+
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        short value = board->tiles[i].value;
+        if (value == 0) {
+            continue;
+        }
+
+        int row_i = i / BOARD_SIZE;
+        int col_i = i % BOARD_SIZE;
+        if (placeDigit(&bitboard, value - 1, row_i / 3, (row_i % 3) * 9 + col_i) == -1) {
+            return -1;
+        }
+    }
+
+    if (search(&bitboard, stats) == -1) {
+        return -1;
+    }
+
+    unsigned char values[BOARD_CELLS];
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        int row_i = i / BOARD_SIZE;
+        int col_i = i % BOARD_SIZE;
+        uint32_t tile = 1u << ((row_i % 3) * 9 + col_i);
+        int digit = 0;
+        while (!(bitboard.planes[digit][row_i / 3] & tile)) {
+            digit++;
+        }
+        values[i] = digit + 1;
+    }
+    setSolvedBoardValues(board, values);
+
+    return 0;
+}
@@ -0,0 +1,11 @@
+#ifndef __BITBOARD_SOLVER_DEFS
+#define __BITBOARD_SOLVER_DEFS
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+
+#if BOARD_SIZE == 9
+int solveBoardBitboard(SudokuBoard*, const SolverOptions*, SolverStats*);
+#endif
+
+#endif
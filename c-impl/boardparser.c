@@ -1,23 +1,40 @@
 #include <stdio.h>
 #include <string.h>
-#include <ctype.h>
 
 #include "sudoku.h"
 #include "inputhandler.h"
+#ifdef VARIANTS
+#include "variants.h"
 
-#define LETTER_0 '0'
+// The rules of the last board read by readBoard. Boards point to them, so
+// they are only valid until the next board is read.
+static VariantRules readRules;
+#endif
 
 /**
  * Attempts to read a board from the given file pointer
- * A board is represented as 9 digits per line (separated by only '\n')
- * Exactly 9 lines are read to complete the board
+ * A board is represented as BOARD_SIZE values per line (separated by only '\n')
+ * Exactly BOARD_SIZE lines are read to complete the board
+ * Values above 9 are written as letters starting from 'A' for 10 (see
+ * characterToValue)
  * Blank spaces are represented as 0
+ * Variant builds also read the rule lines in front of the board (see
+ * variants.c)
  *
  * Returns 0 if the operation was successful and -1 if there was a parse error
  */
 int readBoard(FILE* fp, SudokuBoard* board) {
     emptySudokuBoard(board);
 
+#ifdef VARIANTS
+    if (readVariantRules(fp, &readRules) == -1) {
+        return -1;
+    }
+    if (readRules.variants != 0 || readRules.cageCount > 0) {
+        applyVariantRules(board, &readRules);
+    }
+#endif
+
     char line[BOARD_SIZE];
 
     for (int row_i = 0; row_i < BOARD_SIZE; row_i++) {
@@ -30,11 +47,12 @@ int readBoard(FILE* fp, SudokuBoard* board) {
         for (int i = 0; i < BOARD_SIZE; i++) {
             char c = line[i];
 
-            if (!isdigit(c)) {
+            short value = characterToValue(c);
+            if (value == -1) {
                 // invalid row item
                 return -1;
             }
-            row[i] = c - LETTER_0;
+            row[i] = value;
         }
 
         setBoardRowValues(board, row_i, row);
@@ -43,3 +61,37 @@ int readBoard(FILE* fp, SudokuBoard* board) {
     return 0;
 }
 
+
+/**
+ * Parses a board from a buffer containing exactly BOARD_TEXT_SIZE characters
+ * in the same format accepted by readBoard. Every row, including the last,
+ * must be terminated by a newline.
+ *
+ * Returns 0 if the operation was successful and -1 if there was a parse error
+ */
+int parseBoard(const char* buffer, SudokuBoard* board) {
+    emptySudokuBoard(board);
+
+    for (int row_i = 0; row_i < BOARD_SIZE; row_i++) {
+        const char* line = buffer + row_i * (BOARD_SIZE + 1);
+        if (line[BOARD_SIZE] != '\n') {
+            return -1;
+        }
+
+        short row[BOARD_SIZE];
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            char c = line[i];
+
+            short value = characterToValue(c);
+            if (value == -1) {
+                // invalid row item
+                return -1;
+            }
+            row[i] = value;
+        }
+
+        setBoardRowValues(board, row_i, row);
+    }
+
+    return 0;
+}
@@ -3,6 +3,11 @@
 
 #include "sudoku.h"
 
+// The number of characters used by one board in the text format:
+// BOARD_SIZE rows of BOARD_SIZE characters, each followed by a newline
+#define BOARD_TEXT_SIZE (BOARD_SIZE * (BOARD_SIZE + 1))
+
 int readBoard(FILE*, SudokuBoard*);
+int parseBoard(const char*, SudokuBoard*);
 
 #endif
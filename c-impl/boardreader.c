@@ -0,0 +1,384 @@
+/**
+ * Reads boards from a file through a large buffer instead of a character at
+ * a time
+ *
+ * Two formats are read, and they can be mixed in the same file:
+ * - BOARD_SIZE lines of BOARD_SIZE characters, the format read by readBoard
+ * - A single line of BOARD_CELLS characters, where empty tiles can also be
+ *   written as '.'
+ * The length of the first line tells them apart.
+ *
+ * The file is read with read() as far as it has been written, so boards are
+ * answered as soon as they arrive on a pipe or terminal. Other inputs (such
+ * as the decompressed streams of compressedstream.c) are read through a
+ * ReadInput function.
+ *
+ * For 9x9 boards, the end of a line is found 16 characters at a time and a
+ * whole board is checked and converted to values with a few operations on
+ * 16 characters at once using GCC's vector extensions. Other board sizes,
+ * other compilers and builds with -DNO_SIMD go through the characters one by
+ * one instead.
+ */
+// From: http://stackoverflow.com/a/3875233/551904
+// Used to make fileno visible
+#if __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 600
+#else
+#define _XOPEN_SOURCE 500
+#endif /* __STDC_VERSION__ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sudoku.h"
+#include "boardparser.h"
+#include "boardreader.h"
+
+// The number of characters of a board written on a single line, including
+// its newline
+#define LINE_TEXT_SIZE (BOARD_CELLS + 1)
+// Zeroed characters kept after the end of the buffered text so that reading
+// 16 characters at a time never goes past the end of the buffer
+#define BUFFER_SLACK 128
+
+#if defined(__GNUC__) && !defined(NO_SIMD)
+#define USE_VECTORS
+#endif
+
+#ifdef USE_VECTORS
+
+typedef unsigned char Chunk __attribute__((vector_size(16)));
+
+static inline Chunk loadChunk(const char* text) {
+    Chunk chunk;
+    memcpy(&chunk, text, sizeof(chunk));
+    return chunk;
+}
+
+/**
+ * Returns true if any character of the chunk is not 0
+ */
+static inline bool anyInChunk(Chunk chunk) {
+    uint64_t halves[2];
+    memcpy(halves, &chunk, sizeof(halves));
+    return (halves[0] | halves[1]) != 0;
+}
+
+/**
+ * Returns the index of the first '\n' in the first length characters of text
+ * or -1 if there is none. Up to 15 characters after them may be read.
+ */
+static long findNewline(const char* text, size_t length) {
+    for (size_t offset = 0; offset < length; offset += sizeof(Chunk)) {
+        Chunk newlines = (Chunk)(loadChunk(text + offset) == '\n');
+        if (!anyInChunk(newlines)) {
+            continue;
+        }
+
+        // Every character that matched is 0xFF, so the lowest set bit is in
+        // the first one that matched
+        uint64_t halves[2];
+        memcpy(halves, &newlines, sizeof(halves));
+        size_t index = offset + (halves[0] != 0
+            ? __builtin_ctzll(halves[0]) / 8
+            : 8 + __builtin_ctzll(halves[1]) / 8);
+        return index < length ? (long)index : -1;
+    }
+    return -1;
+}
+
+#else
+
+static long findNewline(const char* text, size_t length) {
+    const char* newline = memchr(text, '\n', length);
+    return newline != NULL ? newline - text : -1;
+}
+
+#endif
+
+#if defined(USE_VECTORS) && BOARD_SIZE == 9
+
+// The number of chunks that cover the text of a board in either format
+#define TEXT_CHUNKS 6
+
+// Masks of each chunk of the text of a board, 0xFF for the characters that
+// must be digits or newlines. They are constant so that threads reading
+// boards at the same time never have to fill them in.
+#define X 0xFF
+// The digits of a board written on BOARD_SIZE lines
+static const Chunk gridDigits[TEXT_CHUNKS] = {
+    {X, X, X, X, X, X, X, X, X, 0, X, X, X, X, X, X},
+    {X, X, X, 0, X, X, X, X, X, X, X, X, X, 0, X, X},
+    {X, X, X, X, X, X, X, 0, X, X, X, X, X, X, X, X},
+    {X, 0, X, X, X, X, X, X, X, X, X, 0, X, X, X, X},
+    {X, X, X, X, X, 0, X, X, X, X, X, X, X, X, X, 0},
+    {X, X, X, X, X, X, X, X, X, 0, 0, 0, 0, 0, 0, 0},
+};
+// The newlines after its lines
+static const Chunk gridNewlines[TEXT_CHUNKS] = {
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, X, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, X, 0, 0, 0, 0, 0, 0, 0, 0, 0, X, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, X, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, X, 0, 0, 0, 0, 0, 0, 0, 0, 0, X, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, X, 0, 0, 0, 0, 0, 0, 0, 0, 0, X},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, X, 0, 0, 0, 0, 0, 0},
+};
+// The digits of a board written on a single line
+static const Chunk lineDigits[TEXT_CHUNKS] = {
+    {X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X},
+    {X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X},
+    {X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X},
+    {X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X},
+    {X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X},
+    {X, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+};
+#undef X
+
+/**
+ * Converts the BOARD_TEXT_SIZE characters of a board written on
+ * BOARD_SIZE lines into values
+ *
+ * Returns 0 if the operation was successful and -1 if there was a parse error
+ */
+static int parseGridText(const char* text, unsigned char values[BOARD_CELLS]) {
+    unsigned char digits[TEXT_CHUNKS * sizeof(Chunk)];
+    Chunk invalid = {0};
+    for (int i = 0; i < TEXT_CHUNKS; i++) {
+        Chunk chunk = loadChunk(text + i * sizeof(Chunk));
+        Chunk digit = chunk - '0';
+        // Characters below '0' wrap around to large values
+        invalid |= ((Chunk)(digit > 9) & gridDigits[i]) | ((Chunk)(chunk != '\n') & gridNewlines[i]);
+        memcpy(digits + i * sizeof(Chunk), &digit, sizeof(Chunk));
+    }
+    if (anyInChunk(invalid)) {
+        return -1;
+    }
+
+    for (int row_i = 0; row_i < BOARD_SIZE; row_i++) {
+        memcpy(values + row_i * BOARD_SIZE, digits + row_i * (BOARD_SIZE + 1), BOARD_SIZE);
+    }
+    return 0;
+}
+
+/**
+ * Converts the BOARD_CELLS characters of a board written on a single line
+ * into values
+ *
+ * Returns 0 if the operation was successful and -1 if there was a parse error
+ */
+static int parseLineText(const char* text, unsigned char values[BOARD_CELLS]) {
+    unsigned char digits[TEXT_CHUNKS * sizeof(Chunk)];
+    Chunk invalid = {0};
+    for (int i = 0; i < TEXT_CHUNKS; i++) {
+        Chunk chunk = loadChunk(text + i * sizeof(Chunk));
+        Chunk dots = (Chunk)(chunk == '.');
+        Chunk digit = chunk - '0';
+        invalid |= (Chunk)(digit > 9) & ~dots & lineDigits[i];
+        digit &= ~dots;
+        memcpy(digits + i * sizeof(Chunk), &digit, sizeof(Chunk));
+    }
+    if (anyInChunk(invalid)) {
+        return -1;
+    }
+
+    memcpy(values, digits, BOARD_CELLS);
+    return 0;
+}
+
+#else
+
+static int parseGridText(const char* text, unsigned char values[BOARD_CELLS]) {
+    for (int row_i = 0; row_i < BOARD_SIZE; row_i++) {
+        const char* line = text + row_i * (BOARD_SIZE + 1);
+        if (line[BOARD_SIZE] != '\n') {
+            return -1;
+        }
+
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            short value = characterToValue(line[i]);
+            if (value == -1) {
+                return -1;
+            }
+            values[row_i * BOARD_SIZE + i] = value;
+        }
+    }
+    return 0;
+}
+
+static int parseLineText(const char* text, unsigned char values[BOARD_CELLS]) {
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        short value = text[i] == '.' ? 0 : characterToValue(text[i]);
+        if (value == -1) {
+            return -1;
+        }
+        values[i] = value;
+    }
+    return 0;
+}
+
+#endif
+
+/**
+ * Reads from the FILE* source with read() so that only what has been written
+ * so far is waited for
+ */
+static long readFile(void* source, char* buffer, size_t size) {
+    ssize_t count;
+    do {
+        count = read(fileno((FILE*)source), buffer, size);
+    } while (count == -1 && errno == EINTR);
+    return count;
+}
+
+/**
+ * Creates a reader of the boards in fp, which must not have been read from
+ * before
+ *
+ * Returns NULL if memory could not be allocated
+ */
+BoardReader* createBoardReader(FILE* fp) {
+    return createBoardReaderFrom(readFile, fp);
+}
+
+/**
+ * Creates a reader of the boards in the input read by readInput from source
+ *
+ * Returns NULL if memory could not be allocated
+ */
+BoardReader* createBoardReaderFrom(ReadInput readInput, void* source) {
+    BoardReader* reader = malloc(sizeof(BoardReader));
+    if (reader == NULL) {
+        return NULL;
+    }
+    // Room for a newline added after the last line as well
+    reader->buffer = malloc(BOARD_READER_BUFFER_SIZE + 1 + BUFFER_SLACK);
+    if (reader->buffer == NULL) {
+        free(reader);
+        return NULL;
+    }
+
+    reader->readInput = readInput;
+    reader->source = source;
+    reader->start = 0;
+    reader->end = 0;
+    reader->endOfFile = false;
+    reader->inputRead = 0;
+    memset(reader->buffer, 0, BUFFER_SLACK);
+    return reader;
+}
+
+void freeBoardReader(BoardReader* reader) {
+    free(reader->buffer);
+    free(reader);
+}
+
+/**
+ * Moves the characters that have not been parsed yet to the front of the
+ * buffer and reads whatever more of the input is available. At the end of
+ * the input (or an error reading it), a newline is added after the last line
+ * if it does not have one.
+ */
+static void fillBuffer(BoardReader* reader) {
+    memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+    reader->end -= reader->start;
+    reader->start = 0;
+
+    long size = reader->readInput(reader->source, reader->buffer + reader->end,
+        BOARD_READER_BUFFER_SIZE - reader->end);
+
+    if (size > 0) {
+        reader->end += size;
+        reader->inputRead += size;
+    }
+    else {
+        reader->endOfFile = true;
+        if (reader->end > 0 && reader->buffer[reader->end - 1] != '\n') {
+            reader->buffer[reader->end++] = '\n';
+        }
+    }
+    memset(reader->buffer + reader->end, 0, BUFFER_SLACK);
+}
+
+/**
+ * Reads the values of the next board (0 for empty tiles)
+ *
+ * Returns 0 if the operation was successful and -1 if there was a parse error
+ * or there are no more boards
+ */
+int readBoardValues(BoardReader* reader, unsigned char values[BOARD_CELLS]) {
+    while (true) {
+        const char* text = reader->buffer + reader->start;
+        size_t available = reader->end - reader->start;
+        long lineLength = findNewline(text, available < LINE_TEXT_SIZE ? available : LINE_TEXT_SIZE);
+
+        if (lineLength == BOARD_SIZE && available >= BOARD_TEXT_SIZE) {
+            if (parseGridText(text, values) == -1) {
+                return -1;
+            }
+            reader->start += BOARD_TEXT_SIZE;
+            return 0;
+        }
+        if (lineLength == BOARD_CELLS) {
+            if (parseLineText(text, values) == -1) {
+                return -1;
+            }
+            reader->start += LINE_TEXT_SIZE;
+            return 0;
+        }
+
+        // Only read more if the rest of the board may still arrive
+        bool incomplete = lineLength == -1 ? available < LINE_TEXT_SIZE : lineLength == BOARD_SIZE;
+        if (!incomplete || reader->endOfFile) {
+            return -1;
+        }
+        fillBuffer(reader);
+    }
+}
+
+/**
+ * Reads the next board like readBoardValues
+ *
+ * Returns 0 if the operation was successful and -1 if there was a parse error
+ * or there are no more boards
+ */
+int readNextBoard(BoardReader* reader, SudokuBoard* board) {
+    unsigned char values[BOARD_CELLS];
+    if (readBoardValues(reader, values) == -1) {
+        return -1;
+    }
+    setBoardValues(board, values);
+    return 0;
+}
+
+/**
+ * Returns true if nothing but whitespace is left of the input, which tells
+ * the end of the boards apart from a board that could not be read after
+ * readBoardValues failed. The whitespace is skipped.
+ */
+bool boardReaderAtEnd(BoardReader* reader) {
+    while (true) {
+        for (; reader->start < reader->end; reader->start++) {
+            if (!isspace((unsigned char)reader->buffer[reader->start])) {
+                return false;
+            }
+        }
+        if (reader->endOfFile) {
+            return true;
+        }
+        fillBuffer(reader);
+    }
+}
+
+/**
+ * Returns the number of characters of the input before the next board, which
+ * is where reading has to start again to read the same boards that are left
+ */
+long boardReaderOffset(const BoardReader* reader) {
+    // The newline added after the last line was never read from the input
+    long offset = reader->inputRead - (long)(reader->end - reader->start);
+    return offset < 0 ? 0 : offset;
+}
@@ -0,0 +1,40 @@
+#ifndef __BOARD_READER_DEFS
+#define __BOARD_READER_DEFS
+
+#include <stdio.h>
+
+#include "sudoku.h"
+
+// The number of characters read from the file at a time
+#define BOARD_READER_BUFFER_SIZE (1 << 20)
+
+// Reads up to the given number of characters of the input from the source
+// into the buffer, waiting until at least one is available. Returns the
+// number of characters read, 0 at the end of the input or -1 on errors.
+typedef long (*ReadInput)(void*, char*, size_t);
+
+typedef struct {
+    ReadInput readInput;
+    void* source;
+    // Characters read from the input but not parsed yet are buffer[start] to
+    // buffer[end - 1]
+    char* buffer;
+    size_t start;
+    size_t end;
+    bool endOfFile;
+    // The number of characters read from the input so far. Can be set before
+    // the first board is read to count characters skipped before the reader
+    // was created.
+    long inputRead;
+} BoardReader;
+
+BoardReader* createBoardReader(FILE*);
+BoardReader* createBoardReaderFrom(ReadInput, void*);
+void freeBoardReader(BoardReader*);
+
+int readBoardValues(BoardReader*, unsigned char[BOARD_CELLS]);
+int readNextBoard(BoardReader*, SudokuBoard*);
+long boardReaderOffset(const BoardReader*);
+bool boardReaderAtEnd(BoardReader*);
+
+#endif
@@ -0,0 +1,210 @@
+/**
+ * Board symmetry transformations and canonical forms
+ *
+ * Two boards that only differ by a transposition, a permutation of rows
+ * within bands, columns within stacks, of whole bands/stacks or by a
+ * relabeling of digits have solutions that differ by exactly the same
+ * transformation. Reducing boards to a canonical form lets them share one
+ * solution.
+ */
+#include <string.h>
+
+#include "sudoku.h"
+#include "boardtransform.h"
+
+/**
+ * Scrambles a count so that sums of mixed values make good sort keys
+ */
+static unsigned int mix(unsigned int value) {
+    value = (value + 0x9e3779b9u) * 0x85ebca6bu;
+    value ^= value >> 13;
+    value *= 0xc2b2ae35u;
+    value ^= value >> 16;
+    return value;
+}
+
+/**
+ * Sorts count indexes (starting at first) in order of descending keys
+ * Stable so ties keep their original order
+ */
+static void sortByKey(unsigned char order[], int first, int count, const unsigned int keys[]) {
+    for (int i = first + 1; i < first + count; i++) {
+        unsigned char current = order[i];
+        int j = i - 1;
+        while (j >= first && keys[order[j]] < keys[current]) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = current;
+    }
+}
+
+/**
+ * Orders the lines (rows or columns) of one orientation of the board
+ *
+ * lineKeys must already describe every line. Groups of BOX_SIZE lines are
+ * ordered by the combination of their line keys, then the lines inside each
+ * group are ordered by their own keys.
+ */
+static void orderLines(const unsigned int lineKeys[BOARD_SIZE], unsigned char order[BOARD_SIZE]) {
+    unsigned int groupKeys[BOX_SIZE];
+    unsigned char groupOrder[BOX_SIZE];
+    for (int g = 0; g < BOX_SIZE; g++) {
+        groupKeys[g] = 0;
+        for (int i = 0; i < BOX_SIZE; i++) {
+            groupKeys[g] += mix(lineKeys[g * BOX_SIZE + i]);
+        }
+        groupOrder[g] = g;
+    }
+    sortByKey(groupOrder, 0, BOX_SIZE, groupKeys);
+
+    for (int g = 0; g < BOX_SIZE; g++) {
+        for (int i = 0; i < BOX_SIZE; i++) {
+            order[g * BOX_SIZE + i] = groupOrder[g] * BOX_SIZE + i;
+        }
+        sortByKey(order, g * BOX_SIZE, BOX_SIZE, lineKeys);
+    }
+}
+
+/**
+ * Builds the transform for a single orientation of the board and applies it
+ */
+static void canonicalizeOrientation(const unsigned char values[BOARD_CELLS], bool transpose,
+        unsigned char canonical[BOARD_CELLS], BoardTransform* transform) {
+    unsigned char grid[BOARD_CELLS];
+    for (int row_i = 0; row_i < BOARD_SIZE; row_i++) {
+        for (int col_i = 0; col_i < BOARD_SIZE; col_i++) {
+            grid[row_i * BOARD_SIZE + col_i] = transpose
+                ? values[col_i * BOARD_SIZE + row_i]
+                : values[row_i * BOARD_SIZE + col_i];
+        }
+    }
+
+    // How often each digit is given does not depend on how digits are labeled
+    unsigned int digitCounts[BOARD_SIZE + 1] = {0};
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        digitCounts[grid[i]]++;
+    }
+    unsigned int digitKeys[BOARD_SIZE + 1];
+    for (int digit = 0; digit <= BOARD_SIZE; digit++) {
+        digitKeys[digit] = mix(digitCounts[digit]);
+    }
+
+    // A line's key starts out as the number of givens on it. It is then
+    // refined by mixing in the keys of the crossing lines of each given and
+    // how common the given digit is. None of that changes under any of the
+    // transformations so equivalent boards usually end up in the same order.
+    // Ties keep their original order, which is still a valid transform, but
+    // may keep some equivalent boards from sharing a canonical form.
+    unsigned int rowKeys[BOARD_SIZE] = {0};
+    unsigned int colKeys[BOARD_SIZE] = {0};
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        if (grid[i] != 0) {
+            rowKeys[i / BOARD_SIZE]++;
+            colKeys[i % BOARD_SIZE]++;
+        }
+    }
+
+    for (int round = 0; round < 2; round++) {
+        unsigned int mixedRowKeys[BOARD_SIZE];
+        unsigned int mixedColKeys[BOARD_SIZE];
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            mixedRowKeys[i] = mix(rowKeys[i]);
+            mixedColKeys[i] = mix(colKeys[i]);
+            rowKeys[i] = mixedRowKeys[i] * 31;
+            colKeys[i] = mixedColKeys[i] * 31;
+        }
+        for (int i = 0; i < BOARD_CELLS; i++) {
+            if (grid[i] != 0) {
+                unsigned int digitKey = digitKeys[grid[i]];
+                rowKeys[i / BOARD_SIZE] += (mixedColKeys[i % BOARD_SIZE] ^ digitKey) * 0x9e3779b1u;
+                colKeys[i % BOARD_SIZE] += (mixedRowKeys[i / BOARD_SIZE] ^ digitKey) * 0x9e3779b1u;
+            }
+        }
+    }
+
+    transform->transpose = transpose;
+    orderLines(rowKeys, transform->rowOrder);
+    orderLines(colKeys, transform->colOrder);
+
+    // Digits are numbered in the order they first appear
+    memset(transform->digitMap, 0, sizeof(transform->digitMap));
+    unsigned char nextDigit = 1;
+    for (int row_i = 0; row_i < BOARD_SIZE; row_i++) {
+        for (int col_i = 0; col_i < BOARD_SIZE; col_i++) {
+            int index = transform->rowOrder[row_i] * BOARD_SIZE + transform->colOrder[col_i];
+            unsigned char value = grid[index];
+            if (value != 0 && transform->digitMap[value] == 0) {
+                transform->digitMap[value] = nextDigit++;
+            }
+            canonical[row_i * BOARD_SIZE + col_i] = transform->digitMap[value];
+        }
+    }
+
+    // Digits that do not appear still need distinct labels for the
+    // transform to be reversible
+    for (int digit = 1; digit <= BOARD_SIZE; digit++) {
+        if (transform->digitMap[digit] == 0) {
+            transform->digitMap[digit] = nextDigit++;
+        }
+    }
+}
+
+/**
+ * Computes the canonical form of the given board values (stored row-wise)
+ * along with the transform that produces it. Applying the same transform to
+ * the board's solution produces the solution of the canonical board.
+ */
+void canonicalizeBoard(const unsigned char values[BOARD_CELLS],
+        unsigned char canonical[BOARD_CELLS], BoardTransform* transform) {
+    unsigned char transposed[BOARD_CELLS];
+    BoardTransform transposedTransform;
+
+    canonicalizeOrientation(values, false, canonical, transform);
+    canonicalizeOrientation(values, true, transposed, &transposedTransform);
+
+    if (memcmp(transposed, canonical, BOARD_CELLS) < 0) {
+        memcpy(canonical, transposed, BOARD_CELLS);
+        *transform = transposedTransform;
+    }
+}
+
+/**
+ * Applies the transform to the given board values
+ */
+void applyBoardTransform(const BoardTransform* transform,
+        const unsigned char values[BOARD_CELLS], unsigned char transformed[BOARD_CELLS]) {
+    for (int row_i = 0; row_i < BOARD_SIZE; row_i++) {
+        for (int col_i = 0; col_i < BOARD_SIZE; col_i++) {
+            int row = transform->rowOrder[row_i];
+            int col = transform->colOrder[col_i];
+            int index = transform->transpose
+                ? col * BOARD_SIZE + row
+                : row * BOARD_SIZE + col;
+            transformed[row_i * BOARD_SIZE + col_i] = transform->digitMap[values[index]];
+        }
+    }
+}
+
+/**
+ * Undoes the transform, turning transformed values back into values for the
+ * original board
+ */
+void invertBoardTransform(const BoardTransform* transform,
+        const unsigned char transformed[BOARD_CELLS], unsigned char values[BOARD_CELLS]) {
+    unsigned char originalDigit[BOARD_SIZE + 1];
+    for (int digit = 0; digit <= BOARD_SIZE; digit++) {
+        originalDigit[transform->digitMap[digit]] = digit;
+    }
+
+    for (int row_i = 0; row_i < BOARD_SIZE; row_i++) {
+        for (int col_i = 0; col_i < BOARD_SIZE; col_i++) {
+            int row = transform->rowOrder[row_i];
+            int col = transform->colOrder[col_i];
+            int index = transform->transpose
+                ? col * BOARD_SIZE + row
+                : row * BOARD_SIZE + col;
+            values[index] = originalDigit[transformed[row_i * BOARD_SIZE + col_i]];
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef __BOARD_TRANSFORM_DEFS
+#define __BOARD_TRANSFORM_DEFS
+
+#include "sudoku.h"
+
+// A validity preserving relabeling of a board: an optional transposition,
+// followed by a permutation of the rows and columns that keeps them inside
+// their bands/stacks and moves whole bands/stacks, followed by a relabeling
+// of the digits
+typedef struct {
+    bool transpose;
+    // Row i of the transformed board is row rowOrder[i] of the
+    // (possibly transposed) original board
+    unsigned char rowOrder[BOARD_SIZE];
+    // Column i of the transformed board is column colOrder[i] of the
+    // (possibly transposed) original board
+    unsigned char colOrder[BOARD_SIZE];
+    // Digit d of the original board becomes digitMap[d], 0 stays 0
+    unsigned char digitMap[BOARD_SIZE + 1];
+} BoardTransform;
+
+void canonicalizeBoard(const unsigned char[BOARD_CELLS], unsigned char[BOARD_CELLS], BoardTransform*);
+void applyBoardTransform(const BoardTransform*, const unsigned char[BOARD_CELLS], unsigned char[BOARD_CELLS]);
+void invertBoardTransform(const BoardTransform*, const unsigned char[BOARD_CELLS], unsigned char[BOARD_CELLS]);
+
+#endif
@@ -0,0 +1,138 @@
+/**
+ * Checkpoints of long timesolvesudoku runs so that they can be resumed
+ * after a crash or being stopped
+ *
+ * A checkpoint is a small text file with one "name value" pair per line.
+ * It is written next to its final path, flushed to disk and then renamed
+ * over the previous checkpoint, so there is always a complete checkpoint
+ * on disk, whether the old one or the new one.
+ */
+#if __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 600
+#else
+#define _XOPEN_SOURCE 500
+#endif /* __STDC_VERSION__ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+
+#define CHECKPOINT_MAGIC "timesolvesudoku-checkpoint"
+#define CHECKPOINT_VERSION 1
+
+/**
+ * Reads the checkpoint at path
+ *
+ * Returns 0 if the checkpoint was read, 1 if there is no checkpoint at path
+ * yet and -1 if it could not be read
+ */
+int readCheckpoint(const char* path, Checkpoint* checkpoint) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        if (errno == ENOENT) {
+            return 1;
+        }
+        perror(path);
+        return -1;
+    }
+
+    int version;
+    int fields = fscanf(fp,
+        CHECKPOINT_MAGIC " %d\n"
+        "inputOffset %ld\n"
+        "outputOffset %ld\n"
+        "totalPuzzles %d\n"
+        "completed %d\n"
+        "averageSolveTime %lf\n"
+        "maxTime %lf\n"
+        "totalGuesses %ld\n"
+        "totalProbes %ld\n"
+        "totalEliminations %ld\n"
+        "totalConflicts %ld\n",
+        &version, &checkpoint->inputOffset, &checkpoint->outputOffset, &checkpoint->totalPuzzles,
+        &checkpoint->completed, &checkpoint->averageSolveTime, &checkpoint->maxTime, &checkpoint->totalGuesses,
+        &checkpoint->totalProbes, &checkpoint->totalEliminations, &checkpoint->totalConflicts);
+    fclose(fp);
+
+    if (fields != 11 || version != CHECKPOINT_VERSION) {
+        fprintf(stderr, "%s: not a checkpoint of this version of timesolvesudoku\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Flushes the directory that contains path to disk so that a file renamed
+ * into it stays there
+ */
+static int syncDirectory(const char* path) {
+    const char* slash = strrchr(path, '/');
+    size_t length = slash == NULL ? 1 : (size_t)(slash - path) + 1;
+    char directory[length + 1];
+    if (slash == NULL) {
+        strcpy(directory, ".");
+    }
+    else {
+        memcpy(directory, path, length);
+        directory[length] = '\0';
+    }
+
+    int fd = open(directory, O_RDONLY);
+    if (fd == -1) {
+        perror(directory);
+        return -1;
+    }
+    int result = fsync(fd);
+    close(fd);
+    return result;
+}
+
+/**
+ * Replaces the checkpoint at path with the given one
+ *
+ * Returns 0 if the checkpoint is on disk and -1 otherwise (the previous
+ * checkpoint is left in place)
+ */
+int writeCheckpoint(const char* path, const Checkpoint* checkpoint) {
+    size_t pathLength = strlen(path);
+    char tempPath[pathLength + 5];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+    FILE* fp = fopen(tempPath, "w");
+    if (fp == NULL) {
+        perror(tempPath);
+        return -1;
+    }
+
+    // Doubles are written with enough digits to be read back exactly
+    fprintf(fp,
+        CHECKPOINT_MAGIC " %d\n"
+        "inputOffset %ld\n"
+        "outputOffset %ld\n"
+        "totalPuzzles %d\n"
+        "completed %d\n"
+        "averageSolveTime %.17g\n"
+        "maxTime %.17g\n"
+        "totalGuesses %ld\n"
+        "totalProbes %ld\n"
+        "totalEliminations %ld\n"
+        "totalConflicts %ld\n",
+        CHECKPOINT_VERSION, checkpoint->inputOffset, checkpoint->outputOffset, checkpoint->totalPuzzles,
+        checkpoint->completed, checkpoint->averageSolveTime, checkpoint->maxTime, checkpoint->totalGuesses,
+        checkpoint->totalProbes, checkpoint->totalEliminations, checkpoint->totalConflicts);
+
+    if (fflush(fp) == EOF || fsync(fileno(fp)) == -1) {
+        perror(tempPath);
+        fclose(fp);
+        return -1;
+    }
+    if (fclose(fp) == EOF || rename(tempPath, path) == -1) {
+        perror(path);
+        return -1;
+    }
+    return syncDirectory(path);
+}
@@ -0,0 +1,23 @@
+#ifndef __CHECKPOINT_DEFS
+#define __CHECKPOINT_DEFS
+
+typedef struct {
+    // The number of characters of the input whose boards were done
+    long inputOffset;
+    // The size of the output written for them
+    long outputOffset;
+    // The totals timesolvesudoku reports at the end so far
+    int totalPuzzles;
+    int completed;
+    double averageSolveTime;
+    double maxTime;
+    long totalGuesses;
+    long totalProbes;
+    long totalEliminations;
+    long totalConflicts;
+} Checkpoint;
+
+int readCheckpoint(const char*, Checkpoint*);
+int writeCheckpoint(const char*, const Checkpoint*);
+
+#endif
@@ -0,0 +1,720 @@
+/**
+ * Reads and writes gzip and zstd compressed streams without a separate
+ * process such as zcat
+ *
+ * Input: the first bytes of the input tell whether it is compressed (by the
+ * magic numbers of gzip and zstd). Compressed input is decompressed on its
+ * own thread straight into a ring buffer that readInputStream copies out of,
+ * so the next boards are decompressed while the current ones are solved.
+ * Concatenated gzip members and zstd frames are read one after another like
+ * zcat does. Plain input is read directly.
+ *
+ * Output: startCompressedOutput points stdout at a pipe and compresses
+ * everything written to it on its own thread, so programs keep writing to
+ * stdout as usual while their output is compressed.
+ *
+ * zstd is only available when compiled with -DHAVE_ZSTD (make ZSTD=1).
+ */
+// From: http://stackoverflow.com/a/3875233/551904
+// Used to make dup visible
+#if __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 600
+#else
+#define _XOPEN_SOURCE 500
+#endif /* __STDC_VERSION__ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h> // malloc, calloc, free
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "compressedstream.h"
+
+// The number of bytes that tell how the input is compressed
+#define MAGIC_SIZE 4
+// The number of decompressed bytes that can be waiting to be read
+#define RING_SIZE (1 << 22)
+// The number of compressed bytes read or written at a time
+#define CHUNK_SIZE (1 << 17)
+
+#define GZIP_LEVEL 6
+#define ZSTD_LEVEL 3
+
+#define NO_ZSTD_MESSAGE "zstd streams are not supported by this build (use make ZSTD=1)"
+
+static const unsigned char gzipMagic[] = {0x1f, 0x8b};
+static const unsigned char zstdMagic[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+struct InputStream {
+    int fd;
+    Compression compression;
+    // The first bytes of the input, read to tell how it is compressed
+    unsigned char header[MAGIC_SIZE];
+    size_t headerSize;
+    // The number of header bytes already returned from plain input
+    size_t headerRead;
+
+    // Decompressed bytes that have not been read yet are
+    // ring[readCount % RING_SIZE] up to ring[writeCount % RING_SIZE]. Both
+    // counts only ever go up.
+    char* ring;
+    size_t readCount;
+    size_t writeCount;
+    // Set by the decompressor when it stops, failed if that was because of
+    // an error
+    bool finished;
+    bool failed;
+    // Set when the stream is closed before the decompressor is finished
+    bool closing;
+    pthread_mutex_t lock;
+    pthread_cond_t readable;
+    pthread_cond_t writable;
+    pthread_t thread;
+};
+
+struct OutputStream {
+    Compression compression;
+    // Where stdout pointed before, which the compressed stream is written to
+    int fd;
+    // The read end of the pipe that stdout points to instead
+    int pipe;
+    bool failed;
+    pthread_t thread;
+};
+
+static size_t minSize(size_t a, size_t b) {
+    return a < b ? a : b;
+}
+
+static long readRetrying(int fd, void* buffer, size_t size) {
+    ssize_t count;
+    do {
+        count = read(fd, buffer, size);
+    } while (count == -1 && errno == EINTR);
+    return count;
+}
+
+/**
+ * Writes all of buffer to fd
+ *
+ * Returns 0 if the operation was successful and -1 if there was an error
+ */
+static int writeAll(int fd, const void* buffer, size_t size) {
+    const char* bytes = buffer;
+    while (size > 0) {
+        ssize_t count = write(fd, bytes, size);
+        if (count == -1 && errno == EINTR) {
+            continue;
+        }
+        if (count == -1) {
+            perror("write");
+            return -1;
+        }
+        bytes += count;
+        size -= count;
+    }
+    return 0;
+}
+
+/**
+ * Parses the name of a compression format: none, gzip or zstd
+ *
+ * Returns 0 if successful, -1 if the name is unknown
+ */
+int parseCompression(const char* name, Compression* compression) {
+    if (strcmp(name, "none") == 0) {
+        *compression = COMPRESSION_NONE;
+    }
+    else if (strcmp(name, "gzip") == 0) {
+        *compression = COMPRESSION_GZIP;
+    }
+    else if (strcmp(name, "zstd") == 0) {
+        *compression = COMPRESSION_ZSTD;
+    }
+    else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Returns true if the first size bytes of the header could be the start of
+ * the given magic number
+ */
+static bool couldBeMagic(const unsigned char* header, size_t size, const unsigned char* magic, size_t magicSize) {
+    return memcmp(header, magic, minSize(size, magicSize)) == 0;
+}
+
+/**
+ * Waits for free space in the ring buffer and points space at it. The space
+ * never wraps around the end of the ring.
+ *
+ * Returns the size of the space or 0 if the stream is being closed
+ */
+static size_t waitForSpace(InputStream* stream, char** space) {
+    pthread_mutex_lock(&stream->lock);
+    while (stream->writeCount - stream->readCount == RING_SIZE && !stream->closing) {
+        pthread_cond_wait(&stream->writable, &stream->lock);
+    }
+    bool closing = stream->closing;
+    size_t available = RING_SIZE - (stream->writeCount - stream->readCount);
+    size_t offset = stream->writeCount % RING_SIZE;
+    pthread_mutex_unlock(&stream->lock);
+
+    if (closing) {
+        return 0;
+    }
+    *space = stream->ring + offset;
+    return minSize(available, RING_SIZE - offset);
+}
+
+/**
+ * Makes the next size bytes written to the space from waitForSpace
+ * available to readInputStream
+ */
+static void publishDecompressed(InputStream* stream, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    pthread_mutex_lock(&stream->lock);
+    stream->writeCount += size;
+    pthread_cond_signal(&stream->readable);
+    pthread_mutex_unlock(&stream->lock);
+}
+
+/**
+ * Decompresses gzip input into the ring buffer until the end of the input
+ *
+ * Returns false if there was an error
+ */
+static bool inflateInput(InputStream* stream, unsigned char* input) {
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    // Adding 32 makes zlib read the gzip header
+    if (inflateInit2(&z, 15 + 32) != Z_OK) {
+        fprintf(stderr, "Unable to start decompressing the input\n");
+        return false;
+    }
+
+    memcpy(input, stream->header, stream->headerSize);
+    z.next_in = input;
+    z.avail_in = stream->headerSize;
+
+    bool ok = true;
+    bool memberEnded = false;
+    // While the last output space was filled, zlib may still have more
+    // output without any more input
+    bool outputFull = false;
+    while (true) {
+        if (z.avail_in == 0 && !outputFull) {
+            long count = readRetrying(stream->fd, input, CHUNK_SIZE);
+            if (count == -1) {
+                perror("read");
+                ok = false;
+                break;
+            }
+            if (count == 0) {
+                if (!memberEnded) {
+                    fprintf(stderr, "The compressed input ends too early\n");
+                    ok = false;
+                }
+                break;
+            }
+            z.next_in = input;
+            z.avail_in = count;
+        }
+        if (memberEnded) {
+            // Another gzip member follows
+            inflateReset(&z);
+            memberEnded = false;
+        }
+
+        char* space;
+        size_t spaceSize = waitForSpace(stream, &space);
+        if (spaceSize == 0) {
+            break;
+        }
+        z.next_out = (unsigned char*)space;
+        z.avail_out = spaceSize;
+
+        int status = inflate(&z, Z_NO_FLUSH);
+        publishDecompressed(stream, spaceSize - z.avail_out);
+        outputFull = z.avail_out == 0;
+        if (status == Z_STREAM_END) {
+            memberEnded = true;
+            outputFull = false;
+        }
+        else if (status != Z_OK && status != Z_BUF_ERROR) {
+            fprintf(stderr, "Unable to decompress the input: %s\n", z.msg != NULL ? z.msg : "invalid data");
+            ok = false;
+            break;
+        }
+    }
+
+    inflateEnd(&z);
+    return ok;
+}
+
+#ifdef HAVE_ZSTD
+/**
+ * Decompresses zstd input into the ring buffer until the end of the input
+ *
+ * Returns false if there was an error
+ */
+static bool decompressZstdInput(InputStream* stream, unsigned char* input) {
+    ZSTD_DCtx* context = ZSTD_createDCtx();
+    if (context == NULL) {
+        fprintf(stderr, "Unable to start decompressing the input\n");
+        return false;
+    }
+
+    memcpy(input, stream->header, stream->headerSize);
+    ZSTD_inBuffer in = {input, stream->headerSize, 0};
+
+    bool ok = true;
+    // 0 once a whole frame has been decompressed and written out
+    size_t remaining = 0;
+    bool outputFull = false;
+    while (true) {
+        if (in.pos == in.size && !outputFull) {
+            long count = readRetrying(stream->fd, input, CHUNK_SIZE);
+            if (count == -1) {
+                perror("read");
+                ok = false;
+                break;
+            }
+            if (count == 0) {
+                if (remaining != 0) {
+                    fprintf(stderr, "The compressed input ends too early\n");
+                    ok = false;
+                }
+                break;
+            }
+            in.size = count;
+            in.pos = 0;
+        }
+
+        char* space;
+        size_t spaceSize = waitForSpace(stream, &space);
+        if (spaceSize == 0) {
+            break;
+        }
+        ZSTD_outBuffer out = {space, spaceSize, 0};
+
+        remaining = ZSTD_decompressStream(context, &out, &in);
+        if (ZSTD_isError(remaining)) {
+            fprintf(stderr, "Unable to decompress the input: %s\n", ZSTD_getErrorName(remaining));
+            ok = false;
+            break;
+        }
+        publishDecompressed(stream, out.pos);
+        outputFull = out.pos == out.size;
+    }
+
+    ZSTD_freeDCtx(context);
+    return ok;
+}
+#endif
+
+static void* decompressInput(void* argument) {
+    InputStream* stream = argument;
+
+    bool ok = false;
+    unsigned char* input = malloc(CHUNK_SIZE);
+    if (input == NULL) {
+        fprintf(stderr, "Unable to allocate the compressed input buffer\n");
+    }
+    else if (stream->compression == COMPRESSION_GZIP) {
+        ok = inflateInput(stream, input);
+    }
+#ifdef HAVE_ZSTD
+    else if (stream->compression == COMPRESSION_ZSTD) {
+        ok = decompressZstdInput(stream, input);
+    }
+#endif
+    free(input);
+
+    pthread_mutex_lock(&stream->lock);
+    stream->finished = true;
+    stream->failed = !ok;
+    pthread_cond_signal(&stream->readable);
+    pthread_mutex_unlock(&stream->lock);
+    return NULL;
+}
+
+/**
+ * Opens the input read from fd, which is decompressed if it starts with the
+ * magic number of gzip or zstd. readInputStream reads the (decompressed)
+ * input.
+ *
+ * Returns NULL if the input could not be read or decompressing it could not
+ * be started
+ */
+InputStream* openInputStream(int fd) {
+    InputStream* stream = calloc(1, sizeof(InputStream));
+    if (stream == NULL) {
+        fprintf(stderr, "Unable to allocate the input stream\n");
+        return NULL;
+    }
+    stream->fd = fd;
+
+    // Only as many bytes as could still be a magic number are read, so plain
+    // input typed on a terminal is not waited for
+    while (stream->headerSize < MAGIC_SIZE
+            && (couldBeMagic(stream->header, stream->headerSize, gzipMagic, sizeof(gzipMagic))
+                || couldBeMagic(stream->header, stream->headerSize, zstdMagic, sizeof(zstdMagic)))) {
+        long count = readRetrying(fd, stream->header + stream->headerSize, MAGIC_SIZE - stream->headerSize);
+        if (count == -1) {
+            perror("read");
+            free(stream);
+            return NULL;
+        }
+        if (count == 0) {
+            break;
+        }
+        stream->headerSize += count;
+    }
+
+    if (stream->headerSize >= sizeof(gzipMagic) && memcmp(stream->header, gzipMagic, sizeof(gzipMagic)) == 0) {
+        stream->compression = COMPRESSION_GZIP;
+    }
+    else if (stream->headerSize >= sizeof(zstdMagic) && memcmp(stream->header, zstdMagic, sizeof(zstdMagic)) == 0) {
+        stream->compression = COMPRESSION_ZSTD;
+    }
+    else {
+        stream->compression = COMPRESSION_NONE;
+        return stream;
+    }
+
+#ifndef HAVE_ZSTD
+    if (stream->compression == COMPRESSION_ZSTD) {
+        fprintf(stderr, "%s\n", NO_ZSTD_MESSAGE);
+        free(stream);
+        return NULL;
+    }
+#endif
+
+    stream->ring = malloc(RING_SIZE);
+    if (stream->ring == NULL) {
+        fprintf(stderr, "Unable to allocate the decompressed input buffer\n");
+        free(stream);
+        return NULL;
+    }
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->readable, NULL);
+    pthread_cond_init(&stream->writable, NULL);
+    if (pthread_create(&stream->thread, NULL, decompressInput, stream) != 0) {
+        fprintf(stderr, "Unable to start decompressing the input\n");
+        pthread_mutex_destroy(&stream->lock);
+        pthread_cond_destroy(&stream->readable);
+        pthread_cond_destroy(&stream->writable);
+        free(stream->ring);
+        free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+/**
+ * Reads up to size bytes of the (decompressed) input of the InputStream
+ * source into buffer, waiting until at least one is available. This is a
+ * ReadInput function, so a BoardReader can read from the stream.
+ *
+ * Returns the number of bytes read, 0 at the end of the input or -1 if
+ * there was an error
+ */
+long readInputStream(void* source, char* buffer, size_t size) {
+    InputStream* stream = source;
+
+    if (stream->compression == COMPRESSION_NONE) {
+        if (stream->headerRead < stream->headerSize) {
+            size_t count = minSize(size, stream->headerSize - stream->headerRead);
+            memcpy(buffer, stream->header + stream->headerRead, count);
+            stream->headerRead += count;
+            return count;
+        }
+        return readRetrying(stream->fd, buffer, size);
+    }
+
+    pthread_mutex_lock(&stream->lock);
+    while (stream->writeCount == stream->readCount && !stream->finished) {
+        pthread_cond_wait(&stream->readable, &stream->lock);
+    }
+    size_t available = stream->writeCount - stream->readCount;
+    size_t offset = stream->readCount % RING_SIZE;
+    bool failed = stream->failed;
+    pthread_mutex_unlock(&stream->lock);
+
+    if (available == 0) {
+        return failed ? -1 : 0;
+    }
+
+    // The decompressor never writes to bytes that have not been read yet, so
+    // they can be copied without holding the lock
+    size_t count = minSize(size, available);
+    size_t first = minSize(count, RING_SIZE - offset);
+    memcpy(buffer, stream->ring + offset, first);
+    memcpy(buffer + first, stream->ring, count - first);
+
+    pthread_mutex_lock(&stream->lock);
+    stream->readCount += count;
+    pthread_cond_signal(&stream->writable);
+    pthread_mutex_unlock(&stream->lock);
+    return count;
+}
+
+/**
+ * Skips the next size bytes of the (decompressed) input. Plain files are
+ * seeked through instead of being read.
+ *
+ * Returns 0 if successful, -1 if the input ended before that or could not
+ * be read
+ */
+int skipInputStream(InputStream* stream, long size) {
+    if (stream->compression == COMPRESSION_NONE) {
+        size_t fromHeader = minSize(size, stream->headerSize - stream->headerRead);
+        stream->headerRead += fromHeader;
+        size -= fromHeader;
+        if (size == 0 || lseek(stream->fd, size, SEEK_CUR) != -1) {
+            return 0;
+        }
+    }
+
+    // Pipes and compressed input can only be read through
+    char discarded[1 << 16];
+    while (size > 0) {
+        long count = readInputStream(stream, discarded, minSize(size, sizeof(discarded)));
+        if (count <= 0) {
+            return -1;
+        }
+        size -= count;
+    }
+    return 0;
+}
+
+/**
+ * Closes the stream (but not its file). A decompressor that has not finished
+ * is stopped once it has read its next block of input.
+ *
+ * Returns 0 if the input was decompressed without errors, -1 otherwise
+ */
+int closeInputStream(InputStream* stream) {
+    int result = 0;
+    if (stream->compression != COMPRESSION_NONE) {
+        pthread_mutex_lock(&stream->lock);
+        stream->closing = true;
+        pthread_cond_signal(&stream->writable);
+        pthread_mutex_unlock(&stream->lock);
+        pthread_join(stream->thread, NULL);
+
+        result = stream->failed ? -1 : 0;
+        pthread_mutex_destroy(&stream->lock);
+        pthread_cond_destroy(&stream->readable);
+        pthread_cond_destroy(&stream->writable);
+        free(stream->ring);
+    }
+    free(stream);
+    return result;
+}
+
+/**
+ * Compresses everything read from the pipe as a gzip stream
+ *
+ * Returns false if there was an error
+ */
+static bool deflateOutput(OutputStream* stream, unsigned char* input, unsigned char* output) {
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    // Adding 16 makes zlib write a gzip header
+    if (deflateInit2(&z, GZIP_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        fprintf(stderr, "Unable to start compressing the output\n");
+        return false;
+    }
+
+    bool ok = true;
+    int flush;
+    do {
+        long count = readRetrying(stream->pipe, input, CHUNK_SIZE);
+        if (count == -1) {
+            perror("read");
+            ok = false;
+            break;
+        }
+        flush = count == 0 ? Z_FINISH : Z_NO_FLUSH;
+        z.next_in = input;
+        z.avail_in = count;
+
+        do {
+            z.next_out = output;
+            z.avail_out = CHUNK_SIZE;
+            deflate(&z, flush);
+            if (writeAll(stream->fd, output, CHUNK_SIZE - z.avail_out) == -1) {
+                ok = false;
+                break;
+            }
+        } while (z.avail_out == 0);
+    } while (ok && flush != Z_FINISH);
+
+    deflateEnd(&z);
+    return ok;
+}
+
+#ifdef HAVE_ZSTD
+/**
+ * Compresses everything read from the pipe as a zstd stream
+ *
+ * Returns false if there was an error
+ */
+static bool compressZstdOutput(OutputStream* stream, unsigned char* input, unsigned char* output) {
+    ZSTD_CCtx* context = ZSTD_createCCtx();
+    if (context == NULL) {
+        fprintf(stderr, "Unable to start compressing the output\n");
+        return false;
+    }
+    ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, ZSTD_LEVEL);
+
+    bool ok = true;
+    ZSTD_EndDirective mode;
+    do {
+        long count = readRetrying(stream->pipe, input, CHUNK_SIZE);
+        if (count == -1) {
+            perror("read");
+            ok = false;
+            break;
+        }
+        mode = count == 0 ? ZSTD_e_end : ZSTD_e_continue;
+        ZSTD_inBuffer in = {input, count, 0};
+
+        // The number of bytes still to be written to finish the frame
+        size_t remaining;
+        do {
+            ZSTD_outBuffer out = {output, CHUNK_SIZE, 0};
+            remaining = ZSTD_compressStream2(context, &out, &in, mode);
+            if (ZSTD_isError(remaining)) {
+                fprintf(stderr, "Unable to compress the output: %s\n", ZSTD_getErrorName(remaining));
+                ok = false;
+                break;
+            }
+            if (writeAll(stream->fd, output, out.pos) == -1) {
+                ok = false;
+                break;
+            }
+        } while (mode == ZSTD_e_end ? remaining != 0 : in.pos < in.size);
+    } while (ok && mode != ZSTD_e_end);
+
+    ZSTD_freeCCtx(context);
+    return ok;
+}
+#endif
+
+static void* compressOutput(void* argument) {
+    OutputStream* stream = argument;
+
+    bool ok = false;
+    unsigned char* input = malloc(CHUNK_SIZE);
+    unsigned char* output = malloc(CHUNK_SIZE);
+    if (input == NULL || output == NULL) {
+        fprintf(stderr, "Unable to allocate the compressed output buffers\n");
+    }
+    else if (stream->compression == COMPRESSION_GZIP) {
+        ok = deflateOutput(stream, input, output);
+    }
+#ifdef HAVE_ZSTD
+    else if (stream->compression == COMPRESSION_ZSTD) {
+        ok = compressZstdOutput(stream, input, output);
+    }
+#endif
+    free(input);
+    free(output);
+    stream->failed = !ok;
+
+    // After an error, the rest of the output is dropped so that the program
+    // is never left waiting to write to a pipe that nobody reads
+    char discarded[4096];
+    while (readRetrying(stream->pipe, discarded, sizeof(discarded)) > 0) {
+    }
+    return NULL;
+}
+
+/**
+ * Compresses everything written to stdout from now on until
+ * finishCompressedOutput is called
+ *
+ * Returns NULL if the output could not be redirected to the compressor
+ */
+OutputStream* startCompressedOutput(Compression compression) {
+#ifndef HAVE_ZSTD
+    if (compression == COMPRESSION_ZSTD) {
+        fprintf(stderr, "%s\n", NO_ZSTD_MESSAGE);
+        return NULL;
+    }
+#endif
+
+    OutputStream* stream = malloc(sizeof(OutputStream));
+    if (stream == NULL) {
+        fprintf(stderr, "Unable to allocate the output stream\n");
+        return NULL;
+    }
+    stream->compression = compression;
+    stream->failed = false;
+
+    int fds[2];
+    if (pipe(fds) == -1) {
+        perror("pipe");
+        free(stream);
+        return NULL;
+    }
+    stream->pipe = fds[0];
+
+    fflush(stdout);
+    stream->fd = dup(STDOUT_FILENO);
+    if (stream->fd == -1 || dup2(fds[1], STDOUT_FILENO) == -1) {
+        perror("dup");
+        if (stream->fd != -1) {
+            close(stream->fd);
+        }
+        close(fds[0]);
+        close(fds[1]);
+        free(stream);
+        return NULL;
+    }
+    // stdout is now the only write end of the pipe
+    close(fds[1]);
+
+    if (pthread_create(&stream->thread, NULL, compressOutput, stream) != 0) {
+        fprintf(stderr, "Unable to start compressing the output\n");
+        dup2(stream->fd, STDOUT_FILENO);
+        close(stream->fd);
+        close(stream->pipe);
+        free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+/**
+ * Writes out the end of the compressed output and points stdout back where
+ * it was before startCompressedOutput
+ *
+ * Returns 0 if all of the output was compressed and written, -1 otherwise
+ */
+int finishCompressedOutput(OutputStream* stream) {
+    fflush(stdout);
+    // Pointing stdout back closes the last write end of the pipe, which is
+    // how the compressor knows that the output is complete
+    dup2(stream->fd, STDOUT_FILENO);
+    pthread_join(stream->thread, NULL);
+
+    int result = stream->failed ? -1 : 0;
+    close(stream->pipe);
+    close(stream->fd);
+    free(stream);
+    return result;
+}
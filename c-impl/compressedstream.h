@@ -0,0 +1,25 @@
+#ifndef __COMPRESSED_STREAM_DEFS
+#define __COMPRESSED_STREAM_DEFS
+
+#include <stddef.h>
+
+typedef enum {
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,
+    COMPRESSION_ZSTD,
+} Compression;
+
+typedef struct InputStream InputStream;
+typedef struct OutputStream OutputStream;
+
+int parseCompression(const char*, Compression*);
+
+InputStream* openInputStream(int);
+long readInputStream(void*, char*, size_t);
+int skipInputStream(InputStream*, long);
+int closeInputStream(InputStream*);
+
+OutputStream* startCompressedOutput(Compression);
+int finishCompressedOutput(OutputStream*);
+
+#endif
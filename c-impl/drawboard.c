@@ -9,8 +9,9 @@
 
 #define COL_CHAR '|'
 #define ROW_CHAR '-'
-#define LETTER_0 '0'
 #define COL_PADDING 1
+// Row numbers need two characters once there are more than 9 rows
+#define ROW_LABEL_WIDTH (BOARD_SIZE < 10 ? 1 : 2)
 
 static void printRepeatedCharacters(char c, int repeated) {
     for (int i = 0; i < repeated; i++) {
@@ -20,14 +21,15 @@ static void printRepeatedCharacters(char c, int repeated) {
 
 static void printRowLine() {
     int tile_width = COL_PADDING*2 + 1;
-    printRepeatedCharacters(ROW_CHAR, 2 + tile_width*BOARD_SIZE + BOX_SIZE+1);
+    printRepeatedCharacters(ROW_CHAR, ROW_LABEL_WIDTH + 1 + tile_width*BOARD_SIZE + BOX_SIZE+1);
     printf("\n");
 }
 
 static void printLetterRow() {
-    printf("  "); // left padding to account for row number
+    // left padding to account for row number
+    printRepeatedCharacters(' ', ROW_LABEL_WIDTH + 1);
     for (int i = 0; i < BOARD_SIZE; i++) {
-        if (i % 3 == 0) {
+        if (i % BOX_SIZE == 0) {
             printf("%c", COL_CHAR);
         }
 
@@ -46,28 +48,27 @@ void drawSudokuBoard(SudokuBoard* board) {
     printRowLine();
     for (int row_i = 0; row_i < BOARD_SIZE; row_i++) {
         // Row number
-        printf("%d ", row_i + 1);
+        printf("%*d ", ROW_LABEL_WIDTH, row_i + 1);
 
         Tile row[BOARD_SIZE];
         getBoardRow(board, row_i, row);
         for (int col_i = 0; col_i < BOARD_SIZE; col_i++) {
             // board column separator
-            if (col_i % 3 == 0) {
+            if (col_i % BOX_SIZE == 0) {
                 printf("%c", COL_CHAR);
             }
 
             // print the value itself
             printRepeatedCharacters(' ', COL_PADDING);
 
-            int value = row[col_i].value;
-            printf("%d", value);
+            printf("%c", valueToCharacter(row[col_i].value));
 
             printRepeatedCharacters(' ', COL_PADDING);
         }
         printf("%c\n", COL_CHAR);
 
         // board row separator
-        if ((row_i+1) % 3 == 0) {
+        if ((row_i+1) % BOX_SIZE == 0) {
             printRowLine();
         }
     }
@@ -81,8 +82,48 @@ void drawSudokuBoardSimple(SudokuBoard* board) {
         Tile row[BOARD_SIZE];
         getBoardRow(board, i, row);
         for (int j = 0; j < BOARD_SIZE; j++) {
-            printf("%d", row[j].value);
+            printf("%c", valueToCharacter(row[j].value));
         }
         printf("\n");
     }
 }
+
+/**
+ * Writes the same output as drawSudokuBoardSimple into the given buffer
+ * instead of stdout. The buffer must have room for
+ * BOARD_SIZE * (BOARD_SIZE + 1) characters. No null terminator is written.
+ *
+ * Returns the number of characters written
+ */
+int formatSudokuBoardSimple(SudokuBoard* board, char buffer[]) {
+    int length = 0;
+    Tile tile;
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            getBoardTile(board, i, j, &tile);
+            buffer[length++] = valueToCharacter(tile.value);
+        }
+        buffer[length++] = '\n';
+    }
+    return length;
+}
+
+/**
+ * Writes the board into the given buffer on a single line with '.' for
+ * empty tiles, followed by a newline. The buffer must have room for
+ * BOARD_SIZE * BOARD_SIZE + 1 characters. No null terminator is written.
+ *
+ * Returns the number of characters written
+ */
+int formatSudokuBoardLine(SudokuBoard* board, char buffer[]) {
+    int length = 0;
+    Tile tile;
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        for (int j = 0; j < BOARD_SIZE; j++) {
+            getBoardTile(board, i, j, &tile);
+            buffer[length++] = tile.value == 0 ? '.' : valueToCharacter(tile.value);
+        }
+    }
+    buffer[length++] = '\n';
+    return length;
+}
@@ -8,5 +8,7 @@
 void clearScreen();
 void drawSudokuBoard(SudokuBoard*);
 void drawSudokuBoardSimple(SudokuBoard*);
+int formatSudokuBoardSimple(SudokuBoard*, char[]);
+int formatSudokuBoardLine(SudokuBoard*, char[]);
 
 #endif
@@ -0,0 +1,370 @@
+/**
+ * Generates random sudoku puzzles with a unique solution
+ *
+ * Every puzzle starts as a random complete board. Values are then removed in
+ * a random order as long as the puzzle keeps a single solution. The
+ * difficulty of a puzzle is the number of guesses the solver needs to prove
+ * that its solution is unique. Values are not removed if that would make the
+ * puzzle harder than the requested difficulty band and puzzles that end up
+ * easier than the band (or with too many givens) are retried.
+ *
+ * Puzzles are generated on several threads. Each puzzle has its own random
+ * number generator seeded from the seed and its position in the output, so
+ * the output only depends on the options and not on the number of threads.
+ *
+ * Usage: generatesudoku [-n count] [-t threads] [-s seed]
+ *                       [--min-guesses n] [--max-guesses n] [--max-givens n]
+ *                       [--format grid|line] [--solutions file]
+ */
+
+#if __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 600
+#else
+#define _XOPEN_SOURCE 500
+#endif /* __STDC_VERSION__ */
+
+#include <stdio.h>
+#include <stdlib.h> // atol, malloc, free, EXIT_FAILURE, EXIT_SUCCESS
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h> // sysconf
+
+#include "sudoku.h"
+#include "drawboard.h"
+#include "puzzlesolver.h"
+#include "boardtransform.h"
+
+// Puzzles are claimed and written by threads in chunks of this many
+#define CHUNK_SIZE 64
+// Attempts for a single puzzle before giving up on the difficulty band
+#define MAX_ATTEMPTS 1000
+
+// The largest number of characters used to write one board in any format
+#define MAX_BOARD_TEXT (BOARD_SIZE * (BOARD_SIZE + 1))
+
+typedef enum {
+    FORMAT_GRID,
+    FORMAT_LINE,
+} OutputFormat;
+
+typedef struct {
+    long count;
+    uint64_t seed;
+    long minGuesses;
+    long maxGuesses;
+    int maxGivens;
+    OutputFormat format;
+    FILE* solutions;
+} GeneratorOptions;
+
+static GeneratorOptions options = {
+    1,
+    1,
+    0,
+    -1,
+    BOARD_CELLS,
+    FORMAT_GRID,
+    NULL,
+};
+
+static pthread_mutex_t outputLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t outputTurn = PTHREAD_COND_INITIALIZER;
+// The index of the next chunk of puzzles to be claimed by a thread
+static long nextPuzzle = 0;
+// The index of the next puzzle to be written
+static long nextWritten = 0;
+// Puzzles that could not be brought into the difficulty band
+static long missedBand = 0;
+
+/**
+ * xorshift64* random number generator
+ */
+static uint64_t nextRandom(uint64_t* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ull;
+}
+
+/**
+ * Returns a random number from 0 up to (not including) bound
+ */
+static int randomBelow(uint64_t* state, int bound) {
+    return nextRandom(state) % bound;
+}
+
+static void shuffle(uint64_t* state, unsigned char items[], int count) {
+    for (int i = count - 1; i > 0; i--) {
+        int j = randomBelow(state, i + 1);
+        unsigned char temp = items[i];
+        items[i] = items[j];
+        items[j] = temp;
+    }
+}
+
+/**
+ * Fills solution with a random complete board
+ */
+static void randomCompleteBoard(uint64_t* rng, unsigned char solution[BOARD_CELLS]) {
+    unsigned char values[BOARD_CELLS] = {0};
+    unsigned char digits[BOARD_SIZE];
+
+    // Boxes on the diagonal do not share any rows or columns so they can be
+    // filled in independently of each other
+    for (int box_i = 0; box_i < BOX_SIZE; box_i++) {
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            digits[i] = i + 1;
+        }
+        shuffle(rng, digits, BOARD_SIZE);
+
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            int row_i = box_i * BOX_SIZE + i / BOX_SIZE;
+            int col_i = box_i * BOX_SIZE + i % BOX_SIZE;
+            values[row_i * BOARD_SIZE + col_i] = digits[i];
+        }
+    }
+
+    // Techniques are always tried so that the board the solver ends up with
+    // does not depend on timing
+    SolverOptions solverOptions = defaultSolverOptions;
+    solverOptions.minTechniquePayoff = 0;
+
+    SudokuBoard board;
+    setBoardValues(&board, values);
+    solveBoardWithOptions(&board, &solverOptions, NULL);
+    getBoardValues(&board, values);
+
+    // The solver always fills the rest of the board the same way, so
+    // scramble the result with a random symmetry transformation
+    BoardTransform transform;
+    transform.transpose = randomBelow(rng, 2);
+
+    unsigned char groups[BOX_SIZE];
+    unsigned char lines[BOX_SIZE];
+    for (int axis = 0; axis < 2; axis++) {
+        unsigned char* order = axis == 0 ? transform.rowOrder : transform.colOrder;
+        for (int i = 0; i < BOX_SIZE; i++) {
+            groups[i] = i;
+        }
+        shuffle(rng, groups, BOX_SIZE);
+
+        for (int g = 0; g < BOX_SIZE; g++) {
+            for (int i = 0; i < BOX_SIZE; i++) {
+                lines[i] = i;
+            }
+            shuffle(rng, lines, BOX_SIZE);
+            for (int i = 0; i < BOX_SIZE; i++) {
+                order[g * BOX_SIZE + i] = groups[g] * BOX_SIZE + lines[i];
+            }
+        }
+    }
+
+    transform.digitMap[0] = 0;
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        digits[i] = i + 1;
+    }
+    shuffle(rng, digits, BOARD_SIZE);
+    memcpy(transform.digitMap + 1, digits, BOARD_SIZE);
+
+    applyBoardTransform(&transform, values, solution);
+}
+
+/**
+ * Removes every value from a complete board that can be removed while it
+ * still has a unique solution and is not harder than the difficulty band
+ *
+ * Returns true if the puzzle ended up within the difficulty band
+ */
+static bool removeValues(uint64_t* rng, unsigned char puzzle[BOARD_CELLS]) {
+    unsigned char order[BOARD_CELLS];
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        order[i] = i;
+    }
+    shuffle(rng, order, BOARD_CELLS);
+
+    SudokuBoard board;
+    SolverStats stats;
+    int givens = BOARD_CELLS;
+    long difficulty = 0;
+
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        int index = order[i];
+        unsigned char removed = puzzle[index];
+        puzzle[index] = 0;
+
+        setBoardValues(&board, puzzle);
+        bool unique = countSolutions(&board, 2, &stats) == 1;
+        bool tooHard = options.maxGuesses >= 0 && stats.guesses > options.maxGuesses;
+        if (!unique || tooHard) {
+            puzzle[index] = removed;
+            continue;
+        }
+
+        givens--;
+        difficulty = stats.guesses;
+    }
+
+    return difficulty >= options.minGuesses && givens <= options.maxGivens;
+}
+
+/**
+ * Generates the puzzle at the given position in the output
+ */
+static void generatePuzzle(long index, unsigned char puzzle[BOARD_CELLS], unsigned char solution[BOARD_CELLS]) {
+    // Seed every puzzle separately so that the output does not depend on
+    // which thread generates it
+    uint64_t rng = (options.seed + 1) * 0x9e3779b97f4a7c15ull ^ (uint64_t)(index + 1) * 0xbf58476d1ce4e5b9ull;
+    if (rng == 0) {
+        rng = 1;
+    }
+
+    for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+        randomCompleteBoard(&rng, solution);
+        memcpy(puzzle, solution, BOARD_CELLS);
+        if (removeValues(&rng, puzzle)) {
+            return;
+        }
+    }
+
+    pthread_mutex_lock(&outputLock);
+    missedBand++;
+    pthread_mutex_unlock(&outputLock);
+}
+
+static int formatBoard(unsigned char values[BOARD_CELLS], char buffer[]) {
+    SudokuBoard board;
+    setBoardValues(&board, values);
+    return options.format == FORMAT_LINE
+        ? formatSudokuBoardLine(&board, buffer)
+        : formatSudokuBoardSimple(&board, buffer);
+}
+
+static void* generateChunks(void* arg) {
+    char* puzzleText = malloc(CHUNK_SIZE * MAX_BOARD_TEXT);
+    char* solutionText = malloc(CHUNK_SIZE * MAX_BOARD_TEXT);
+    if (puzzleText == NULL || solutionText == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned char puzzle[BOARD_CELLS];
+    unsigned char solution[BOARD_CELLS];
+    while (true) {
+        pthread_mutex_lock(&outputLock);
+        long start = nextPuzzle;
+        nextPuzzle += CHUNK_SIZE;
+        pthread_mutex_unlock(&outputLock);
+
+        if (start >= options.count) {
+            break;
+        }
+
+        long end = start + CHUNK_SIZE < options.count ? start + CHUNK_SIZE : options.count;
+        int puzzleLength = 0;
+        int solutionLength = 0;
+        for (long index = start; index < end; index++) {
+            generatePuzzle(index, puzzle, solution);
+            puzzleLength += formatBoard(puzzle, puzzleText + puzzleLength);
+            solutionLength += formatBoard(solution, solutionText + solutionLength);
+        }
+
+        // Chunks are written in order
+        pthread_mutex_lock(&outputLock);
+        while (nextWritten != start) {
+            pthread_cond_wait(&outputTurn, &outputLock);
+        }
+        fwrite(puzzleText, 1, puzzleLength, stdout);
+        if (options.solutions != NULL) {
+            fwrite(solutionText, 1, solutionLength, options.solutions);
+        }
+        nextWritten = end;
+        pthread_cond_broadcast(&outputTurn);
+        pthread_mutex_unlock(&outputLock);
+    }
+
+    free(puzzleText);
+    free(solutionText);
+    return NULL;
+}
+
+static void printUsage(char* program) {
+    fprintf(stderr, "Usage: %s [-n count] [-t threads] [-s seed]\n"
+        "\t[--min-guesses n] [--max-guesses n] [--max-givens n]\n"
+        "\t[--format grid|line] [--solutions file]\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "-n") == 0 && hasValue) {
+            options.count = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-t") == 0 && hasValue) {
+            threadCount = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-s") == 0 && hasValue) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--min-guesses") == 0 && hasValue) {
+            options.minGuesses = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-guesses") == 0 && hasValue) {
+            options.maxGuesses = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-givens") == 0 && hasValue) {
+            options.maxGivens = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--format") == 0 && hasValue) {
+            i++;
+            if (strcmp(argv[i], "grid") == 0) {
+                options.format = FORMAT_GRID;
+            }
+            else if (strcmp(argv[i], "line") == 0) {
+                options.format = FORMAT_LINE;
+            }
+            else {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--solutions") == 0 && hasValue) {
+            options.solutions = fopen(argv[++i], "w");
+            if (options.solutions == NULL) {
+                perror(argv[i]);
+                return EXIT_FAILURE;
+            }
+        }
+        else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+
+    pthread_t threads[threadCount];
+    for (long i = 0; i < threadCount; i++) {
+        if (pthread_create(&threads[i], NULL, generateChunks, NULL) != 0) {
+            perror("pthread_create");
+            return EXIT_FAILURE;
+        }
+    }
+    for (long i = 0; i < threadCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (options.solutions != NULL) {
+        fclose(options.solutions);
+    }
+
+    if (missedBand > 0) {
+        fprintf(stderr, "%ld puzzles could not be generated within the difficulty band\n", missedBand);
+    }
+
+    return EXIT_SUCCESS;
+}
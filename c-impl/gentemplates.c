@@ -0,0 +1,80 @@
+/**
+ * Generates templates.c: every way to place a single digit on a 9x9 board
+ *
+ * A template puts the digit on one tile of every row so that no two of them
+ * share a column or a box. They are listed in order of the column used in
+ * the first row, then the second row and so on.
+ *
+ * Usage: gentemplates > templates.c
+ */
+#include <stdio.h>
+#include <stdlib.h> // EXIT_FAILURE, EXIT_SUCCESS
+#include <stdint.h>
+
+#include "templates.h"
+
+static uint32_t bands[3][TEMPLATE_COUNT];
+static int count = 0;
+
+/**
+ * Places the digit on every possible column of the row and continues with
+ * the next row. columns and boxes are the columns and boxes (of the current
+ * band) used so far, one bit each.
+ */
+static void placeRow(int row, int columns, int boxes, uint32_t template[3]) {
+    if (row == 9) {
+        for (int band = 0; band < 3; band++) {
+            bands[band][count] = template[band];
+        }
+        count++;
+        return;
+    }
+
+    // Every band starts with no boxes used
+    if (row % 3 == 0) {
+        boxes = 0;
+    }
+    for (int col = 0; col < 9; col++) {
+        if ((columns & (1 << col)) || (boxes & (1 << (col / 3)))) {
+            continue;
+        }
+        uint32_t bit = 1u << ((row % 3) * 9 + col);
+        template[row / 3] |= bit;
+        placeRow(row + 1, columns | (1 << col), boxes | (1 << (col / 3)), template);
+        template[row / 3] &= ~bit;
+    }
+}
+
+int main(void) {
+    uint32_t template[3] = {0, 0, 0};
+    placeRow(0, 0, 0, template);
+
+    if (count != TEMPLATE_COUNT) {
+        fprintf(stderr, "Expected %d templates, found %d\n", TEMPLATE_COUNT, count);
+        return EXIT_FAILURE;
+    }
+
+    // The template engine skips whole runs of templates that share bands
+    for (int t = 0; t < TEMPLATE_COUNT; t++) {
+        if (bands[0][t] != bands[0][t - t % TEMPLATES_PER_FIRST_BAND]
+                || bands[1][t] != bands[1][t - t % TEMPLATES_PER_SECOND_BAND]) {
+            fprintf(stderr, "Template %d is not in a run of templates with the same bands\n", t);
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("// Generated by gentemplates (see gentemplates.c), do not edit\n");
+    printf("#include <stdint.h>\n\n");
+    printf("#include \"templates.h\"\n\n");
+    printf("const uint32_t templateBands[3][TEMPLATE_COUNT] __attribute__((aligned(32))) = {\n");
+    for (int band = 0; band < 3; band++) {
+        printf("    {");
+        for (int t = 0; t < TEMPLATE_COUNT; t++) {
+            printf(t % 6 == 0 ? "\n        0x%07x," : " 0x%07x,", (unsigned int)bands[band][t]);
+        }
+        printf("\n    },\n");
+    }
+    printf("};\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/**
+ * Bulk loads a solution store from a file of boards and a file with the
+ * solution of each of those boards (in the same order)
+ *
+ * Usage: loadsolutions <store> <boards file> <solutions file>
+ *
+ * Solutions that are incomplete, invalid or that do not match their board
+ * are reported and skipped.
+ */
+
+#include <stdio.h>
+#include <stdlib.h> // EXIT_FAILURE, EXIT_SUCCESS
+
+#include "sudoku.h"
+#include "boardparser.h"
+#include "solutionstore.h"
+
+/**
+ * Returns whether solution is a complete, valid board that agrees with
+ * every value already on board
+ */
+static bool isSolutionOf(SudokuBoard* solution, SudokuBoard* board) {
+    if (!isCompleteBoard(solution)) {
+        return false;
+    }
+
+    Tile tile, solved;
+    for (int row_i = 0; row_i < BOARD_SIZE; row_i++) {
+        for (int col_i = 0; col_i < BOARD_SIZE; col_i++) {
+            getBoardTile(board, row_i, col_i, &tile);
+            getBoardTile(solution, row_i, col_i, &solved);
+            if (tile.value != 0 && tile.value != solved.value) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s <store> <boards file> <solutions file>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE* boards = fopen(argv[2], "r");
+    if (boards == NULL) {
+        perror(argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    FILE* solutions = fopen(argv[3], "r");
+    if (solutions == NULL) {
+        perror(argv[3]);
+        return EXIT_FAILURE;
+    }
+
+    SolutionStore* store = openSolutionStore(argv[1], true);
+    if (store == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    long before = countStoredSolutions(store);
+    int total = 0;
+    int skipped = 0;
+
+    SudokuBoard board, solution;
+    unsigned char values[BOARD_CELLS];
+    unsigned char packed[PACKED_BOARD_BYTES];
+    unsigned char packedSolution[PACKED_BOARD_BYTES];
+    while (readBoard(boards, &board) == 0) {
+        total++;
+
+        if (readBoard(solutions, &solution) == -1) {
+            fprintf(stderr, "Missing solution for board #%d\n", total);
+            skipped++;
+            break;
+        }
+
+        if (!isSolutionOf(&solution, &board)) {
+            fprintf(stderr, "Incorrect solution for board #%d\n", total);
+            skipped++;
+            continue;
+        }
+
+        getBoardValues(&board, values);
+        packBoardValues(values, packed);
+        getBoardValues(&solution, values);
+        packBoardValues(values, packedSolution);
+
+        if (addStoredSolution(store, packed, packedSolution) == -1) {
+            closeSolutionStore(store);
+            return EXIT_FAILURE;
+        }
+    }
+
+    long added = countStoredSolutions(store) - before;
+    fprintf(stderr, "Added %ld of %d solutions (%d skipped, %ld already stored)\n",
+        added, total, skipped, total - skipped - added);
+
+    closeSolutionStore(store);
+    fclose(boards);
+    fclose(solutions);
+
+    return EXIT_SUCCESS;
+}
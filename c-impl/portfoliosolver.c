@@ -0,0 +1,209 @@
+/**
+ * Portfolio solving: races differently configured searches on one board
+ *
+ * How long a search takes depends a lot on which tiles it guesses on and in
+ * which order it tries values, and a board that is pathological for one
+ * configuration is usually easy for another. The portfolio engine runs
+ * several configurations of the classic solver at the same time on their
+ * own threads and takes whichever result comes first. The other searches
+ * are cancelled through a shared flag that every search checks at each
+ * level.
+ *
+ * The calling thread runs the first search itself. The others run on a
+ * pool of threads that is started the first time it is needed and kept for
+ * later boards, so no threads are created per board.
+ */
+#include <stdio.h>
+#include <stdlib.h> // exit, EXIT_FAILURE
+#include <pthread.h>
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+#include "portfoliosolver.h"
+
+// The most searches that can be raced on one board
+#define PORTFOLIO_MAX 16
+
+// The board currently being solved, shared with the pool
+static struct {
+    // Incremented for every board so that workers notice new work
+    long generation;
+    // The number of searches racing on this board
+    int size;
+    SudokuBoard board;
+    const SolverOptions* options;
+    // Set once a search finished; tells every other search to stop
+    int cancel;
+    // The search that finished first, -1 until then or if every search
+    // ran out of guesses
+    int winner;
+    int result;
+    SudokuBoard solution;
+    SolverStats stats;
+    // Pool threads still working on this board
+    int running;
+} job;
+
+// Only one board is solved at a time
+static pthread_mutex_t callerLock = PTHREAD_MUTEX_INITIALIZER;
+// Protects job.generation and job.running
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobReady = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t jobDone = PTHREAD_COND_INITIALIZER;
+
+static int poolSize = 0;
+
+/**
+ * Builds the options for the search with the given index out of the
+ * options the engine was called with
+ *
+ * The first search uses the options as given. The second flips the tile
+ * tie-break and tries values from the largest down. The rest break ties
+ * randomly with their own seed and every other one also tries values in a
+ * random order.
+ */
+static void configureSearch(int search, const SolverOptions* base, SolverOptions* options) {
+    *options = *base;
+    options->cancel = &job.cancel;
+
+    if (search == 1) {
+        options->degreeTieBreak = !base->degreeTieBreak;
+        options->valueOrder = VALUE_ORDER_DESCENDING;
+    }
+    else if (search >= 2) {
+        options->seed = base->seed + search;
+        if (search % 2 == 1) {
+            options->valueOrder = VALUE_ORDER_RANDOM;
+        }
+    }
+}
+
+/**
+ * Runs the search with the given index on its own copy of the board and
+ * records its result if it finished first. stats is filled with the
+ * statistics of the search either way.
+ */
+static void runSearch(int search, SolverStats* stats) {
+    SolverOptions options;
+    configureSearch(search, job.options, &options);
+
+    SudokuBoard board;
+    copySudokuBoard(&job.board, &board);
+    int result = solveBoardWithOptions(&board, &options, stats);
+
+    // A search that failed because it was cancelled or ran out of guesses
+    // did not finish. Failing otherwise means the board has no solution.
+    if (result == -1 && (stats->budgetExhausted || __atomic_load_n(&job.cancel, __ATOMIC_ACQUIRE))) {
+        return;
+    }
+
+    int expected = -1;
+    if (__atomic_compare_exchange_n(&job.winner, &expected, search, false,
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        job.result = result;
+        copySudokuBoard(&board, &job.solution);
+        job.stats = *stats;
+        __atomic_store_n(&job.cancel, 1, __ATOMIC_RELEASE);
+    }
+}
+
+static void* poolThread(void* arg) {
+    int search = (int)(long)arg;
+    long seen = 0;
+
+    pthread_mutex_lock(&poolLock);
+    while (true) {
+        while (job.generation == seen) {
+            pthread_cond_wait(&jobReady, &poolLock);
+        }
+        seen = job.generation;
+        if (search >= job.size) {
+            continue;
+        }
+        pthread_mutex_unlock(&poolLock);
+
+        SolverStats stats;
+        runSearch(search, &stats);
+
+        pthread_mutex_lock(&poolLock);
+        job.running--;
+        if (job.running == 0) {
+            pthread_cond_signal(&jobDone);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Starts pool threads until there is one for every search after the first
+ */
+static void growPool(int size) {
+    while (poolSize < size - 1) {
+        pthread_t thread;
+        // Pool thread n runs search n + 1
+        if (pthread_create(&thread, NULL, poolThread, (void*)(long)(poolSize + 1)) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+        pthread_detach(thread);
+        poolSize++;
+    }
+}
+
+/**
+ * Solves the board by racing options->portfolioSize differently configured
+ * searches against each other (see configureSearch)
+ * stats (if not NULL) is filled with the statistics of the search that won
+ * or, if every search ran out of guesses, of the first search
+ *
+ * Returns 0 if solving was successful, -1 otherwise
+ */
+int solveBoardPortfolio(SudokuBoard* board, const SolverOptions* options, SolverStats* stats) {
+    int size = options->portfolioSize;
+    if (size < 1) {
+        size = 1;
+    }
+    if (size > PORTFOLIO_MAX) {
+        size = PORTFOLIO_MAX;
+    }
+
+    pthread_mutex_lock(&callerLock);
+    pthread_mutex_lock(&poolLock);
+    // New pool threads cannot look at the job before it is ready since
+    // that needs poolLock
+    growPool(size);
+
+    copySudokuBoard(board, &job.board);
+    job.options = options;
+    job.size = size;
+    job.cancel = 0;
+    job.winner = -1;
+    job.running = size - 1;
+    job.generation++;
+    pthread_cond_broadcast(&jobReady);
+    pthread_mutex_unlock(&poolLock);
+
+    SolverStats firstStats;
+    runSearch(0, &firstStats);
+
+    // The pool must be done with the board before it can be reused
+    pthread_mutex_lock(&poolLock);
+    while (job.running > 0) {
+        pthread_cond_wait(&jobDone, &poolLock);
+    }
+    pthread_mutex_unlock(&poolLock);
+
+    // Without a winner every search ran out of guesses, which is reported
+    // with the statistics of the first search
+    bool won = job.winner != -1;
+    int result = won ? job.result : -1;
+    if (result == 0) {
+        copySudokuBoard(&job.solution, board);
+    }
+    if (stats != NULL) {
+        *stats = won ? job.stats : firstStats;
+    }
+
+    pthread_mutex_unlock(&callerLock);
+    return result;
+}
@@ -0,0 +1,9 @@
+#ifndef __PORTFOLIO_SOLVER_DEFS
+#define __PORTFOLIO_SOLVER_DEFS
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+
+int solveBoardPortfolio(SudokuBoard*, const SolverOptions*, SolverStats*);
+
+#endif
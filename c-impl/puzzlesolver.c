@@ -1,15 +1,99 @@
+// From: http://stackoverflow.com/a/3875233/551904
+// Used to prevent `storage size of start isn't known` error
+#if __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 600
+#else
+#define _XOPEN_SOURCE 500
+#endif /* __STDC_VERSION__ */
+
 #include <stdlib.h> // NULL
+#include <time.h>
 
 #include "sudoku.h"
+#include "puzzlesolver.h"
+#include "techniques.h"
+
+#define BILLION (1000000000L)
+
+#define TECHNIQUE_COUNT 3
+// Every technique is tried this many times before its payoff counts
+#define TECHNIQUE_WARMUP 16
+// Techniques that do not pay off are still tried every this many times
+#define TECHNIQUE_RETRY_INTERVAL 8
+// Payoff is measured over roughly this many of the latest tries
+#define TECHNIQUE_HISTORY 256
+
+static const struct {
+    unsigned int flag;
+    // Returns the number of possible values ruled out, -1 for a dead end
+    int (*find)(SudokuBoard*);
+} techniques[TECHNIQUE_COUNT] = {
+    // Cheapest first
+    {TECHNIQUE_NAKED_SUBSETS, findNakedSubsets},
+    {TECHNIQUE_HIDDEN_SUBSETS, findHiddenSubsets},
+    {TECHNIQUE_FISH, findFish},
+};
 
-struct TilePosition {
-    int row;
-    int col;
+// How well a technique has paid off so far in a search
+struct TechniquePayoff {
+    long tries;
+    long skips;
+    long eliminations;
+    long nanoseconds;
 };
 
-static void simpleSolver(SudokuBoard*);
-static int eliminateSolver(SudokuBoard*);
-static int minimumTile(SudokuBoard*, struct TilePosition*);
+// State shared by every level of a single search
+struct SearchState {
+    // The search stops once this many solutions have been found
+    int maxSolutions;
+    // The number of solutions found so far
+    int solutions;
+    // The number of guesses leading to the current level
+    int depth;
+    const SolverOptions* options;
+    SolverStats* stats;
+    struct TechniquePayoff payoffs[TECHNIQUE_COUNT];
+    // State of the random number generator, used if options->seed is set
+    uint64_t random;
+    // Set once the search noticed that it was cancelled or ran out of
+    // guesses
+    bool cancelled;
+};
+
+const SolverOptions defaultSolverOptions = {
+    true,
+    0,
+    0,
+    ALL_TECHNIQUES,
+    0.1,
+    VALUE_ORDER_ASCENDING,
+    0,
+    NULL,
+    4,
+    0,
+};
+
+// The guesses counted by countSolutions measure how hard a board is, so
+// they must not depend on how fast techniques happened to run
+static const SolverOptions countingOptions = {
+    true,
+    0,
+    0,
+    ALL_TECHNIQUES,
+    0.0,
+    VALUE_ORDER_ASCENDING,
+    0,
+    NULL,
+    1,
+    0,
+};
+
+static int search(SudokuBoard*, struct SearchState*);
+static int simpleSolver(SudokuBoard*);
+static int logicSolver(SudokuBoard*, struct SearchState*);
+static int probeSolver(SudokuBoard*, struct SearchState*);
+static int eliminateSolver(SudokuBoard*, struct SearchState*);
+static int minimumTile(SudokuBoard*, struct SearchState*);
 
 /**
  * Sudoku solving algorithm.
@@ -17,72 +101,321 @@ static int minimumTile(SudokuBoard*, struct TilePosition*);
  * Returns 0 if solving was successful, -1 otherwise
  */
 int solveBoard(SudokuBoard* board) {
+    return solveBoardWithOptions(board, &defaultSolverOptions, NULL);
+}
+
+/**
+ * Solves the board like solveBoard with the given solver options
+ * stats (if not NULL) is filled with the statistics of the search
+ *
+ * Returns 0 if solving was successful, -1 otherwise
+ */
+int solveBoardWithOptions(SudokuBoard* board, const SolverOptions* options, SolverStats* stats) {
+    SolverStats localStats;
+    struct SearchState state = {1, 0, 0, options, stats != NULL ? stats : &localStats, {{0}},
+        (options->seed + 1) * 0x9e3779b97f4a7c15ull, false};
+    *state.stats = (SolverStats) {0};
+    return search(board, &state);
+}
+
+/**
+ * Counts the solutions of the board, stopping once maxSolutions have been
+ * found. The board is not modified.
+ * stats (if not NULL) is filled with the statistics of the search, so for
+ * a board with a unique solution it describes how hard it was to prove
+ * that the solution is unique.
+ *
+ * Returns the number of solutions found
+ */
+int countSolutions(SudokuBoard* board, int maxSolutions, SolverStats* stats) {
+    SolverStats localStats;
+    struct SearchState state = {maxSolutions, 0, 0, &countingOptions,
+        stats != NULL ? stats : &localStats, {{0}}, 1, false};
+    *state.stats = (SolverStats) {0};
+
+    SudokuBoard copy;
+    copySudokuBoard(board, &copy);
+    search(&copy, &state);
+
+    return state.solutions;
+}
+
+/**
+ * Solves the board as far as possible and then guesses
+ *
+ * Returns 0 once the search has found as many solutions as it needs (the
+ * last one is left on the board), -1 otherwise
+ */
+static int search(SudokuBoard* board, struct SearchState* state) {
+    int* cancel = state->options->cancel;
+    if (cancel != NULL && __atomic_load_n(cancel, __ATOMIC_RELAXED)) {
+        state->cancelled = true;
+        return -1;
+    }
+
     // Very simple algorithm that continually fills in values with only one
     // possible value
-    simpleSolver(board);
+    if (simpleSolver(board) == -1) {
+        return -1;
+    }
+
+    if (state->options->techniques != 0 && logicSolver(board, state) == -1) {
+        return -1;
+    }
+
+    if (state->depth < state->options->probeDepth && probeSolver(board, state) == -1) {
+        return -1;
+    }
 
     if (isCompleteBoard(board)) {
-        return 0;
+        state->solutions++;
+        return state->solutions >= state->maxSolutions ? 0 : -1;
     }
 
-    return eliminateSolver(board);
+    return eliminateSolver(board, state);
 }
 
 /**
  * The first tier and simplest solving algorithm.
  *
- * This algorithm goes through all empty tiles and checks what values
- * are available/valid for each tile. If there is only one possibility, that
- * is placed on that space.
+ * This algorithm fills in every empty tile that has only one possible
+ * value left. Placing a value can leave other tiles with only one possible
+ * value, so this continues until there are no such tiles left. The board
+ * keeps those tiles in its tilesByCount index so they are found without
+ * going through the entire board.
  *
  * Solves as much as possible. Complete solution not guaranteed.
+ * Stops as soon as the board turns out to be a dead end.
  *
  * Modifies the board in place.
+ *
+ * Returns -1 if the board is a dead end, 0 otherwise
  */
-static void simpleSolver(SudokuBoard* board) {
-    // foundValue is used to track whether a tile was solved this time
-    // through the board
-    // We continue going through all the available tiles on the board
-    // until we can't solve any more values with this method
-    bool foundValue;
+static int simpleSolver(SudokuBoard* board) {
+    while (!isDeadEndBoard(board)) {
+        int index = firstTileInSet(&board->tilesByCount[1]);
+        if (index == -1) {
+            // Unable to solve anything else, stop trying
+            return 0;
+        }
 
-    Tile tile;
-    while (true) {
-        // These variables need to be inside the loop so that they
-        // reset every time the algorithm goes back through the entire
-        // board
-        foundValue = false;
-
-        for (int row_i = 0; row_i < BOARD_SIZE; row_i++) {
-            for (int col_i = 0; col_i < BOARD_SIZE; col_i++) {
-                getBoardTile(board, row_i, col_i, &tile);
-
-                // Is this an empty tile or at least a tile with
-                // only one possible move left?
-                if (tile.value != 0 || tile.possibleCount != 1) {
-                    continue;
-                }
+        // The only possible value is the only one left in the set
+        short only_value = lowestCandidate(board->tiles[index].possibleValues);
+        placeSudokuValue(board, index / BOARD_SIZE, index % BOARD_SIZE, only_value);
+    }
 
-                bool* possibleValues = tile.possibleValues;
+    return -1;
+}
 
-                // The only possible value is the one that is true
-                short only_value = 0;
-                for (int k = 0; k < BOARD_SIZE; k++) {
-                    if (possibleValues[k]) {
-                        only_value = k + 1;
-                        break;
-                    }
+static long currentNanoseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * BILLION + now.tv_nsec;
+}
+
+/**
+ * Decides whether a technique is worth trying based on how many possible
+ * values it ruled out per microsecond so far
+ */
+static bool shouldTryTechnique(struct SearchState* state, int technique) {
+    struct TechniquePayoff* payoff = &state->payoffs[technique];
+    double minPayoff = state->options->minTechniquePayoff;
+    if (minPayoff <= 0 || payoff->tries < TECHNIQUE_WARMUP) {
+        return true;
+    }
+    if (payoff->eliminations * 1000.0 >= minPayoff * payoff->nanoseconds) {
+        return true;
+    }
+    // Try it once in a while anyway since it may start paying off later in
+    // the search
+    payoff->skips++;
+    return payoff->skips % TECHNIQUE_RETRY_INTERVAL == 0;
+}
+
+static void recordTechniquePayoff(struct SearchState* state, int technique,
+        int eliminated, long nanoseconds) {
+    struct TechniquePayoff* payoff = &state->payoffs[technique];
+    payoff->tries++;
+    payoff->eliminations += eliminated > 0 ? eliminated : 0;
+    payoff->nanoseconds += nanoseconds;
+
+    // Older tries count less so the payoff follows the search
+    if (payoff->tries >= TECHNIQUE_HISTORY) {
+        payoff->tries /= 2;
+        payoff->eliminations /= 2;
+        payoff->nanoseconds /= 2;
+    }
+}
+
+/**
+ * Logical tier of solving, run once the first tier is stuck
+ *
+ * Tries the enabled techniques from cheapest to most expensive. Whenever
+ * one of them rules out possible values, the first tier is run again and
+ * the techniques start over from the cheapest one.
+ *
+ * Modifies the board in place.
+ *
+ * Returns -1 if the board is a dead end, 0 otherwise
+ */
+static int logicSolver(SudokuBoard* board, struct SearchState* state) {
+    int technique = 0;
+    while (technique < TECHNIQUE_COUNT && !isCompleteBoard(board)) {
+        if (!(state->options->techniques & techniques[technique].flag)
+                || !shouldTryTechnique(state, technique)) {
+            technique++;
+            continue;
+        }
+
+        long start = currentNanoseconds();
+        int eliminated = techniques[technique].find(board);
+        recordTechniquePayoff(state, technique, eliminated, currentNanoseconds() - start);
+
+        if (eliminated == -1) {
+            return -1;
+        }
+        if (eliminated == 0) {
+            technique++;
+            continue;
+        }
+
+        state->stats->eliminations += eliminated;
+        if (simpleSolver(board) == -1) {
+            return -1;
+        }
+        technique = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * Tries both values of a tile with two possible values using only the
+ * first tier of solving, leaving the board in first and second
+ *
+ * If one of the values leads to a dead end the other one must be right, so
+ * the board is replaced with the board it leads to. Otherwise the values
+ * that both boards ended up with are placed on the board.
+ *
+ * Returns 1 if the board changed, 0 if it did not and -1 if both values
+ * lead to a dead end
+ */
+static int probeTile(SudokuBoard* board, int index, SudokuBoard* first,
+        SudokuBoard* second, struct SearchState* state) {
+    int row_i = index / BOARD_SIZE;
+    int col_i = index % BOARD_SIZE;
+    CandidateMask possibleValues = board->tiles[index].possibleValues;
+
+    state->stats->probes++;
+
+    copySudokuBoard(board, first);
+    placeSudokuValue(first, row_i, col_i, lowestCandidate(possibleValues));
+    bool firstFailed = simpleSolver(first) == -1;
+
+    copySudokuBoard(board, second);
+    placeSudokuValue(second, row_i, col_i, lowestCandidate(possibleValues & (possibleValues - 1)));
+    bool secondFailed = simpleSolver(second) == -1;
+
+    if (firstFailed && secondFailed) {
+        return -1;
+    }
+    if (firstFailed) {
+        copySudokuBoard(second, board);
+        return 1;
+    }
+    if (secondFailed) {
+        copySudokuBoard(first, board);
+        return 1;
+    }
+
+    bool placed = false;
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        short value = first->tiles[i].value;
+        if (board->tiles[i].value == 0 && value != 0 && value == second->tiles[i].value) {
+            placeSudokuValue(board, i / BOARD_SIZE, i % BOARD_SIZE, value);
+            placed = true;
+        }
+    }
+
+    if (placed && simpleSolver(board) == -1) {
+        return -1;
+    }
+    return placed ? 1 : 0;
+}
+
+/**
+ * Probing tier of solving, run before guessing
+ *
+ * Goes through the tiles with two possible values (up to probeLimit at a
+ * time) and probes each of them. Starts over as long as probing finds
+ * something since that can make other tiles worth probing again.
+ *
+ * Modifies the board in place.
+ *
+ * Returns -1 if the board is a dead end, 0 otherwise
+ */
+static int probeSolver(SudokuBoard* board, struct SearchState* state) {
+    SudokuBoard first;
+    SudokuBoard second;
+
+    bool changed = true;
+    while (changed && !isCompleteBoard(board)) {
+        changed = false;
+
+        // The board changes while probing, so work through the tiles that
+        // had two possible values at the start
+        TileSet pairs = board->tilesByCount[2];
+        int probed = 0;
+        for (int i = 0; i < TILE_SET_WORDS && probed < state->options->probeLimit; i++) {
+            uint64_t word = pairs.words[i];
+            while (word != 0 && probed < state->options->probeLimit) {
+                int index = i * 64 + __builtin_ctzll(word);
+                word &= word - 1;
+
+                Tile* tile = &board->tiles[index];
+                if (tile->value != 0 || tile->possibleCount != 2) {
+                    continue;
                 }
 
-                placeSudokuValue(board, row_i, col_i, only_value);
-                foundValue = true;
+                int result = probeTile(board, index, &first, &second, state);
+                if (result == -1) {
+                    return -1;
+                }
+                if (result == 1) {
+                    changed = true;
+                }
+                probed++;
             }
         }
+    }
+
+    return 0;
+}
+
+/**
+ * xorshift64* random number generator
+ */
+static uint64_t nextRandom(struct SearchState* state) {
+    state->random ^= state->random >> 12;
+    state->random ^= state->random << 25;
+    state->random ^= state->random >> 27;
+    return state->random * 2685821657736338717ull;
+}
 
-        // Unable to solve anything else, stop trying
-        if (!foundValue) {
-            break;
+/**
+ * Picks the next value to guess out of the values not tried yet
+ */
+static short nextGuess(CandidateMask possibleValues, struct SearchState* state) {
+    switch (state->options->valueOrder) {
+    case VALUE_ORDER_DESCENDING:
+        return highestCandidate(possibleValues);
+    case VALUE_ORDER_RANDOM:
+        for (int skip = nextRandom(state) % countCandidates(possibleValues); skip > 0; skip--) {
+            possibleValues &= possibleValues - 1;
         }
+        return lowestCandidate(possibleValues);
+    default:
+        return lowestCandidate(possibleValues);
     }
 }
 
@@ -95,9 +428,9 @@ static void simpleSolver(SudokuBoard* board) {
  * continues
  * Only fails if all possible solutions are exhausted.
  *
- * Returns 0 if a solution was found, -1 otherwise
+ * Returns 0 if the search found all of the solutions it needs, -1 otherwise
  */
-static int eliminateSolver(SudokuBoard* board) {
+static int eliminateSolver(SudokuBoard* board, struct SearchState* state) {
     // Get the tile with the minimum number of possibilities
     // This is the most efficient place to start guessing because
     // if we guess wrong we will have the fewest number of alternatives
@@ -106,43 +439,56 @@ static int eliminateSolver(SudokuBoard* board) {
     // of possible values, we elimate more possible routes by guessing
     // right. I'm just betting that we'll guess wrong more often then
     // we guess right since there are more wrong numbers than right ones.
-    struct TilePosition minTile;
-    if (minimumTile(board, &minTile) == -1) {
+    int index = minimumTile(board, state);
+    if (index == -1) {
         return -1;
     }
 
-    int row_i = minTile.row;
-    int col_i = minTile.col;
+    int row_i = index / BOARD_SIZE;
+    int col_i = index % BOARD_SIZE;
 
     Tile tile;
     getBoardTile(board, row_i, col_i, &tile);
 
-    bool* possibleValues = tile.possibleValues;
+    // Only values that can possibly be solutions are tried
+    CandidateMask possibleValues = tile.possibleValues;
 
     SudokuBoard copy;
-    for (int j = 0; j < BOARD_SIZE; j++) {
-        if (!possibleValues[j]) {
-            // Skip values that cannot possibly be solutions
-            continue;
-        }
+    while (possibleValues != 0) {
+        short guess = nextGuess(possibleValues, state);
+        possibleValues &= ~CANDIDATE_BIT(guess);
 
-        // The value at this index is to be used as the guess
-        // Each index in possibleValues represents a value from 1-9
-        // Adding 1 to the index produces the value
-        short guess = j + 1;
+        long budget = state->options->guessBudget;
+        if (budget > 0 && state->stats->guesses >= budget) {
+            state->cancelled = true;
+            state->stats->budgetExhausted = true;
+            return -1;
+        }
 
         // retrieve a copy of a board
         copySudokuBoard(board, &copy);
 
         // Make a guess
         placeSudokuValue(&copy, row_i, col_i, guess);
+        state->stats->guesses++;
+
+        // A guess that leaves a tile without possible values cannot be right
+        if (isDeadEndBoard(&copy)) {
+            continue;
+        }
 
         // Try to solve the board with this guess
-        if (solveBoard(&copy) == 0) {
+        state->depth++;
+        int result = search(&copy, state);
+        state->depth--;
+        if (result == 0) {
             // copy the solution back onto the other board
             copySudokuBoard(&copy, board);
             return 0;
         }
+        if (state->cancelled) {
+            return -1;
+        }
     }
 
     // Exhausted this route. It's possible that a guess from before
@@ -151,35 +497,72 @@ static int eliminateSolver(SudokuBoard* board) {
 }
 
 /**
- * Returns the tile with the minimum number of possibilities
- *
- * Returns 0 if successful, -1 if no tile was found
+ * Returns the number of empty tiles in the row, column and box of the tile
+ * at the given index. Tiles in more than one of them are counted twice.
  */
-static int minimumTile(SudokuBoard* board, struct TilePosition* minTilePos) {
-    Tile* minTile = NULL;
+static int emptyPeerCount(SudokuBoard* board, int index) {
+    int row_i = index / BOARD_SIZE;
+    int col_i = index % BOARD_SIZE;
+    int box_i = (row_i / BOX_SIZE) * BOX_SIZE + col_i / BOX_SIZE;
+    return 3 * BOARD_SIZE - countCandidates(board->rowValues[row_i])
+        - countCandidates(board->colValues[col_i])
+        - countCandidates(board->boxValues[box_i]);
+}
 
-    Tile tile;
-    for (int row_i = 0; row_i < BOARD_SIZE; row_i++) {
-        for (int col_i = 0; col_i < BOARD_SIZE; col_i++) {
-            getBoardTile(board, row_i, col_i, &tile);
-            if (tile.value != 0) {
-                continue; // tile is already filled, move on
+/**
+ * Returns the index of the empty tile with the minimum number of
+ * possibilities
+ *
+ * The board keeps its empty tiles indexed by their number of possibilities
+ * so this is the first tile in the first non-empty set of that index. With
+ * degreeTieBreak, the tile in that set with the most empty peers is used
+ * instead since guessing on it constrains the most other tiles. With a
+ * seed, the tile is picked randomly out of the tiles that are tied.
+ *
+ * Returns -1 if no tile was found
+ */
+static int minimumTile(SudokuBoard* board, struct SearchState* state) {
+    const SolverOptions* options = state->options;
+    for (int count = 1; count <= BOARD_SIZE; count++) {
+        const TileSet* tiles = &board->tilesByCount[count];
+        if (!options->degreeTieBreak && options->seed == 0) {
+            int index = firstTileInSet(tiles);
+            if (index != -1) {
+                return index;
             }
+            continue;
+        }
 
-            int possibleCount = tile.possibleCount;
+        int minIndex = -1;
+        int maxDegree = -1;
+        int ties = 0;
+        for (int i = 0; i < TILE_SET_WORDS; i++) {
+            uint64_t word = tiles->words[i];
+            while (word != 0) {
+                int index = i * 64 + __builtin_ctzll(word);
+                word &= word - 1;
 
-            if (minTile == NULL || possibleCount < minTile->possibleCount) {
-                minTile = &tile;
-                minTilePos->row = row_i;
-                minTilePos->col = col_i;
+                int degree = options->degreeTieBreak ? emptyPeerCount(board, index) : 0;
+                if (degree > maxDegree) {
+                    minIndex = index;
+                    maxDegree = degree;
+                    ties = 1;
+                }
+                else if (degree == maxDegree && options->seed != 0) {
+                    // Every tied tile ends up being picked with the same
+                    // probability
+                    ties++;
+                    if (nextRandom(state) % ties == 0) {
+                        minIndex = index;
+                    }
+                }
             }
         }
-    }
 
-    if (minTile == NULL) {
-        return -1;
+        if (minIndex != -1) {
+            return minIndex;
+        }
     }
 
-    return 0;
+    return -1;
 }
-
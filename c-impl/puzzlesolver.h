@@ -3,6 +3,70 @@
 
 #include "sudoku.h"
 
+typedef struct {
+    // The number of values the solver had to guess
+    long guesses;
+    // The number of tiles with two possible values that were probed
+    long probes;
+    // The number of possible values ruled out by logical techniques
+    long eliminations;
+    // The number of conflicts the SAT engine learned a clause from
+    long conflicts;
+    // Set if the search gave up because it ran out of guesses
+    // (options->guessBudget), which does not mean that there is no solution
+    bool budgetExhausted;
+} SolverStats;
+
+// Logical techniques the solver can use before guessing (see techniques.c)
+#define TECHNIQUE_NAKED_SUBSETS 1
+#define TECHNIQUE_HIDDEN_SUBSETS 2
+#define TECHNIQUE_FISH 4
+#define ALL_TECHNIQUES (TECHNIQUE_NAKED_SUBSETS | TECHNIQUE_HIDDEN_SUBSETS | TECHNIQUE_FISH)
+
+// The order in which the values of a tile are guessed
+typedef enum {
+    VALUE_ORDER_ASCENDING,
+    VALUE_ORDER_DESCENDING,
+    VALUE_ORDER_RANDOM,
+} ValueOrder;
+
+typedef struct {
+    // Among the tiles with the fewest possible values, guess on the one
+    // with the most empty tiles in its row, column and box
+    bool degreeTieBreak;
+    // Before guessing at the first probeDepth levels of the search, both
+    // values of up to probeLimit tiles with two possible values are tried
+    // with simple solving only. A value that fails is ruled out and values
+    // that both sides place are placed right away. 0 turns probing off.
+    int probeDepth;
+    int probeLimit;
+    // The logical techniques (TECHNIQUE_* flags) tried before probing and
+    // guessing
+    unsigned int techniques;
+    // Techniques that ruled out fewer possible values per microsecond than
+    // this so far in the search are only tried once in a while. 0 always
+    // tries every technique.
+    double minTechniquePayoff;
+    ValueOrder valueOrder;
+    // Seeds the random choices of the search: ties between tiles to guess
+    // on are broken randomly unless this is 0, and values are guessed in a
+    // random order with VALUE_ORDER_RANDOM
+    uint64_t seed;
+    // The search gives up (and fails) as soon as this is set to non-zero
+    // by another thread. Not checked if NULL.
+    int* cancel;
+    // The number of differently configured searches the portfolio engine
+    // races against each other (see portfoliosolver.c)
+    int portfolioSize;
+    // The classic search gives up (and fails) instead of making more than
+    // this many guesses. 0 means there is no limit.
+    long guessBudget;
+} SolverOptions;
+
+extern const SolverOptions defaultSolverOptions;
+
 int solveBoard(SudokuBoard*);
+int solveBoardWithOptions(SudokuBoard*, const SolverOptions*, SolverStats*);
+int countSolutions(SudokuBoard*, int, SolverStats*);
 
 #endif
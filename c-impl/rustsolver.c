@@ -0,0 +1,39 @@
+/**
+ * The solver of the Rust crate in the parent directory, called through its C
+ * API (../capi). Only linked in by building with make RUST_SOLVER=1.
+ *
+ * The board is handed over as the values of its tiles, which the Rust
+ * solver reads and solves in place without allocating.
+ */
+#include <stdlib.h> // NULL
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+#include "rustsolver.h"
+#include "sudoku_capi.h"
+
+#if BOARD_SIZE == 9
+
+/**
+ * Solves a 9x9 board with the Rust solver
+ * options are not used and the Rust solver does not count its guesses, so
+ * stats (if not NULL) is only cleared.
+ *
+ * Returns 0 if solving was successful, -1 otherwise
+ */
+int solveBoardRust(SudokuBoard* board, const SolverOptions* options, SolverStats* stats) {
+    if (stats != NULL) {
+        *stats = (SolverStats) {0};
+    }
+
+    unsigned char values[BOARD_CELLS];
+    getBoardValues(board, values);
+    if (sudoku_solve(values) != SUDOKU_OK) {
+        return -1;
+    }
+    setSolvedBoardValues(board, values);
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef __RUST_SOLVER_DEFS
+#define __RUST_SOLVER_DEFS
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+
+#if BOARD_SIZE == 9
+int solveBoardRust(SudokuBoard*, const SolverOptions*, SolverStats*);
+#endif
+
+#endif
@@ -0,0 +1,753 @@
+/**
+ * SAT engine: solves the board as a boolean satisfiability problem
+ *
+ * The board is encoded in conjunctive normal form with one variable for
+ * every possible value of every empty tile. Every tile has exactly one
+ * value and every value that is not placed yet in a row, column or box
+ * goes on exactly one of its tiles. Each "exactly one" is a clause saying
+ * at least one of the variables is true plus a clause for every pair of
+ * them saying that they are not both true.
+ *
+ * The clauses are solved with a small conflict driven clause learning
+ * solver:
+ * - Two literals of every clause are watched, so a clause is only looked
+ *   at when one of those becomes false
+ * - Every conflict is analyzed back to its first unique implication point
+ *   and the clause learned from it makes the search jump back to the
+ *   level where that clause forces a value
+ * - The variables that took part in recent conflicts are decided first
+ *   (VSIDS) and take the value they last had (phase saving)
+ * - The search restarts after a number of conflicts following the Luby
+ *   sequence. Restarts are also when learned clauses that connect many
+ *   decision levels are thrown away.
+ *
+ * The backtracking solvers can take exponentially long on boards built to
+ * defeat their heuristics. Learned clauses keep the SAT engine from
+ * running into the same conflict twice, which makes it a good fallback
+ * for those boards (see the escalating engine in solverengine.c).
+ */
+#include <stdio.h>
+#include <stdlib.h> // malloc, realloc, free, exit, EXIT_FAILURE
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+#include "satsolver.h"
+
+// A literal is 2 * variable, plus one if it is negated
+#define LITERAL(var, negated) (2 * (var) + (negated))
+#define LITERAL_VAR(literal) ((literal) >> 1)
+#define NEGATE(literal) ((literal) ^ 1)
+
+// Values of variables and literals
+#define FALSE 0
+#define TRUE 1
+#define UNASSIGNED 2
+
+// Every clause is stored as its size and its LBD followed by its literals.
+// The LBD (the number of decision levels among the literals when it was
+// learned) is 0 for clauses of the encoding.
+#define CLAUSE_HEADER 2
+// Marks variables without a reason: decisions and values set at level 0
+#define NO_REASON (-1)
+// propagate returns this if there was no conflict
+#define NO_CONFLICT (-1)
+
+// Conflicts before the first restart, multiplied by the Luby sequence
+#define RESTART_BASE 64
+#define ACTIVITY_DECAY 0.95
+// Learned clauses are thrown away once there are more than this many,
+// and the limit then grows by half
+#define INITIAL_MAX_LEARNED 2000
+// Learned clauses with an LBD up to this are never thrown away
+#define KEEP_LBD 2
+
+typedef struct {
+    int* items;
+    int count;
+    int capacity;
+} IntVector;
+
+typedef struct {
+    int varCount;
+    // Every clause, one after the other (see CLAUSE_HEADER)
+    IntVector clauses;
+    // The clauses watching every literal
+    IntVector* watches;
+
+    // Per variable
+    unsigned char* values;
+    int* levels;
+    int* reasons;
+    unsigned char* phases;
+    double* activity;
+    bool* seen;
+
+    // The assigned literals in the order they were assigned
+    int* trail;
+    int trailCount;
+    // The trail up to here has been propagated
+    int propagated;
+    // Where every decision level starts on the trail
+    IntVector levelStarts;
+
+    // Variables by activity (a binary heap), with the position of every
+    // variable in it or -1
+    int* heap;
+    int heapCount;
+    int* heapIndex;
+    double activityIncrement;
+
+    int learnedCount;
+    int maxLearned;
+    // Used while analyzing conflicts
+    IntVector learned;
+    int* levelStamps;
+    int stamp;
+
+    long conflicts;
+    long decisions;
+} SatSolver;
+
+static void* allocate(size_t size) {
+    void* memory = malloc(size);
+    if (memory == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+static void pushInt(IntVector* vector, int item) {
+    if (vector->count == vector->capacity) {
+        vector->capacity = vector->capacity == 0 ? 4 : 2 * vector->capacity;
+        vector->items = realloc(vector->items, vector->capacity * sizeof(int));
+        if (vector->items == NULL) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    vector->items[vector->count++] = item;
+}
+
+static inline int decisionLevel(SatSolver* solver) {
+    return solver->levelStarts.count;
+}
+
+static inline int literalValue(SatSolver* solver, int literal) {
+    unsigned char value = solver->values[LITERAL_VAR(literal)];
+    return value == UNASSIGNED ? UNASSIGNED : value ^ (literal & 1);
+}
+
+static void heapUp(SatSolver* solver, int i) {
+    int var = solver->heap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!(solver->activity[var] > solver->activity[solver->heap[parent]])) {
+            break;
+        }
+        solver->heap[i] = solver->heap[parent];
+        solver->heapIndex[solver->heap[i]] = i;
+        i = parent;
+    }
+    solver->heap[i] = var;
+    solver->heapIndex[var] = i;
+}
+
+static void heapDown(SatSolver* solver, int i) {
+    int var = solver->heap[i];
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= solver->heapCount) {
+            break;
+        }
+        if (child + 1 < solver->heapCount
+                && solver->activity[solver->heap[child + 1]] > solver->activity[solver->heap[child]]) {
+            child++;
+        }
+        if (!(solver->activity[solver->heap[child]] > solver->activity[var])) {
+            break;
+        }
+        solver->heap[i] = solver->heap[child];
+        solver->heapIndex[solver->heap[i]] = i;
+        i = child;
+    }
+    solver->heap[i] = var;
+    solver->heapIndex[var] = i;
+}
+
+static void heapInsert(SatSolver* solver, int var) {
+    if (solver->heapIndex[var] != -1) {
+        return;
+    }
+    solver->heap[solver->heapCount] = var;
+    solver->heapIndex[var] = solver->heapCount;
+    solver->heapCount++;
+    heapUp(solver, solver->heapCount - 1);
+}
+
+static int heapRemoveMax(SatSolver* solver) {
+    int var = solver->heap[0];
+    solver->heapIndex[var] = -1;
+    solver->heapCount--;
+    if (solver->heapCount > 0) {
+        solver->heap[0] = solver->heap[solver->heapCount];
+        solver->heapIndex[solver->heap[0]] = 0;
+        heapDown(solver, 0);
+    }
+    return var;
+}
+
+/**
+ * Makes the variable more likely to be decided on next
+ */
+static void bumpActivity(SatSolver* solver, int var) {
+    solver->activity[var] += solver->activityIncrement;
+    if (solver->activity[var] > 1e100) {
+        // Scaling every activity keeps their order
+        for (int i = 0; i < solver->varCount; i++) {
+            solver->activity[i] *= 1e-100;
+        }
+        solver->activityIncrement *= 1e-100;
+    }
+    if (solver->heapIndex[var] != -1) {
+        heapUp(solver, solver->heapIndex[var]);
+    }
+}
+
+static void assign(SatSolver* solver, int literal, int reason) {
+    int var = LITERAL_VAR(literal);
+    solver->values[var] = (literal & 1) ? FALSE : TRUE;
+    solver->levels[var] = decisionLevel(solver);
+    solver->reasons[var] = reason;
+    solver->trail[solver->trailCount++] = literal;
+}
+
+/**
+ * Undoes every assignment above the given decision level
+ */
+static void backtrack(SatSolver* solver, int level) {
+    if (decisionLevel(solver) <= level) {
+        return;
+    }
+    int start = solver->levelStarts.items[level];
+    for (int i = solver->trailCount - 1; i >= start; i--) {
+        int var = LITERAL_VAR(solver->trail[i]);
+        solver->phases[var] = solver->values[var];
+        solver->values[var] = UNASSIGNED;
+        heapInsert(solver, var);
+    }
+    solver->trailCount = start;
+    solver->propagated = start;
+    solver->levelStarts.count = level;
+}
+
+/**
+ * Adds a clause (at least two literals) and watches its first two literals
+ * Returns the offset of the clause
+ */
+static int addClause(SatSolver* solver, const int* literals, int size, int lbd) {
+    int clause = solver->clauses.count;
+    pushInt(&solver->clauses, size);
+    pushInt(&solver->clauses, lbd);
+    for (int i = 0; i < size; i++) {
+        pushInt(&solver->clauses, literals[i]);
+    }
+    pushInt(&solver->watches[literals[0]], clause);
+    pushInt(&solver->watches[literals[1]], clause);
+    return clause;
+}
+
+/**
+ * Assigns every literal implied by the trail so far
+ *
+ * Returns the offset of a clause with every literal false if there is one,
+ * NO_CONFLICT otherwise
+ */
+static int propagate(SatSolver* solver) {
+    int* clauses = solver->clauses.items;
+
+    while (solver->propagated < solver->trailCount) {
+        int falseLiteral = NEGATE(solver->trail[solver->propagated++]);
+        IntVector* watches = &solver->watches[falseLiteral];
+
+        int kept = 0;
+        for (int i = 0; i < watches->count; i++) {
+            int clause = watches->items[i];
+            int size = clauses[clause];
+            int* literals = &clauses[clause + CLAUSE_HEADER];
+
+            // The false literal is kept second
+            if (literals[0] == falseLiteral) {
+                literals[0] = literals[1];
+                literals[1] = falseLiteral;
+            }
+            if (literalValue(solver, literals[0]) == TRUE) {
+                watches->items[kept++] = clause;
+                continue;
+            }
+
+            // Watch another literal that is not false instead
+            bool moved = false;
+            for (int k = 2; k < size; k++) {
+                if (literalValue(solver, literals[k]) != FALSE) {
+                    literals[1] = literals[k];
+                    literals[k] = falseLiteral;
+                    pushInt(&solver->watches[literals[1]], clause);
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved) {
+                continue;
+            }
+
+            watches->items[kept++] = clause;
+            if (literalValue(solver, literals[0]) == FALSE) {
+                // Keep the rest of the watches
+                while (++i < watches->count) {
+                    watches->items[kept++] = watches->items[i];
+                }
+                watches->count = kept;
+                return clause;
+            }
+            assign(solver, literals[0], clause);
+        }
+        watches->count = kept;
+    }
+    return NO_CONFLICT;
+}
+
+/**
+ * Learns a clause from the conflict: the literals of the conflict are
+ * replaced with the literals that implied them until only one literal of
+ * the current decision level is left (the first unique implication point)
+ *
+ * The clause is left in solver->learned with the literal of the current
+ * level first and one of the highest remaining level second.
+ * Returns the LBD of the clause.
+ */
+static int analyze(SatSolver* solver, int conflict) {
+    int* clauses = solver->clauses.items;
+    IntVector* learned = &solver->learned;
+    learned->count = 0;
+    // The first literal is filled in at the end
+    pushInt(learned, 0);
+
+    int level = decisionLevel(solver);
+    int pending = 0;
+    int literal = -1;
+    int index = solver->trailCount - 1;
+    int clause = conflict;
+
+    do {
+        int size = clauses[clause];
+        int* literals = &clauses[clause + CLAUSE_HEADER];
+        // The first literal of a reason is the literal it implied
+        for (int i = literal == -1 ? 0 : 1; i < size; i++) {
+            int var = LITERAL_VAR(literals[i]);
+            if (solver->seen[var] || solver->levels[var] == 0) {
+                continue;
+            }
+            solver->seen[var] = true;
+            bumpActivity(solver, var);
+            if (solver->levels[var] == level) {
+                pending++;
+            }
+            else {
+                pushInt(learned, literals[i]);
+            }
+        }
+
+        // The latest assigned literal of this level that took part
+        while (!solver->seen[LITERAL_VAR(solver->trail[index])]) {
+            index--;
+        }
+        literal = solver->trail[index--];
+        clause = solver->reasons[LITERAL_VAR(literal)];
+        solver->seen[LITERAL_VAR(literal)] = false;
+        pending--;
+    } while (pending > 0);
+    learned->items[0] = NEGATE(literal);
+
+    // Literals implied only by other literals of the clause are redundant
+    int kept = 1;
+    for (int i = 1; i < learned->count; i++) {
+        int var = LITERAL_VAR(learned->items[i]);
+        int reason = solver->reasons[var];
+        bool redundant = reason != NO_REASON;
+        if (redundant) {
+            int size = clauses[reason];
+            int* literals = &clauses[reason + CLAUSE_HEADER];
+            for (int k = 1; k < size; k++) {
+                int other = LITERAL_VAR(literals[k]);
+                if (!solver->seen[other] && solver->levels[other] > 0) {
+                    redundant = false;
+                    break;
+                }
+            }
+        }
+        if (!redundant) {
+            // Swapped so that the redundant literals are still there to
+            // be unmarked below
+            int swap = learned->items[kept];
+            learned->items[kept++] = learned->items[i];
+            learned->items[i] = swap;
+        }
+    }
+    for (int i = 1; i < learned->count; i++) {
+        solver->seen[LITERAL_VAR(learned->items[i])] = false;
+    }
+    learned->count = kept;
+
+    // Backjumping goes to the highest level left, so that literal is watched
+    int highest = 1;
+    for (int i = 2; i < learned->count; i++) {
+        if (solver->levels[LITERAL_VAR(learned->items[i])]
+                > solver->levels[LITERAL_VAR(learned->items[highest])]) {
+            highest = i;
+        }
+    }
+    if (learned->count > 1) {
+        int swap = learned->items[1];
+        learned->items[1] = learned->items[highest];
+        learned->items[highest] = swap;
+    }
+
+    solver->stamp++;
+    int lbd = 0;
+    for (int i = 0; i < learned->count; i++) {
+        int literalLevel = solver->levels[LITERAL_VAR(learned->items[i])];
+        if (solver->levelStamps[literalLevel] != solver->stamp) {
+            solver->levelStamps[literalLevel] = solver->stamp;
+            lbd++;
+        }
+    }
+    return lbd;
+}
+
+/**
+ * Throws away satisfied clauses and learned clauses with a high LBD, then
+ * watches the clauses that are left again. Only done at level 0, where no
+ * reason is ever looked at again.
+ */
+static void reduceClauses(SatSolver* solver) {
+    int* clauses = solver->clauses.items;
+    int end = solver->clauses.count;
+    int kept = 0;
+    solver->learnedCount = 0;
+
+    for (int i = 0; i < 2 * solver->varCount; i++) {
+        solver->watches[i].count = 0;
+    }
+
+    for (int clause = 0; clause < end; ) {
+        int size = clauses[clause];
+        int lbd = clauses[clause + 1];
+        int* literals = &clauses[clause + CLAUSE_HEADER];
+        int next = clause + CLAUSE_HEADER + size;
+
+        bool satisfied = false;
+        for (int i = 0; i < size; i++) {
+            if (literalValue(solver, literals[i]) == TRUE) {
+                satisfied = true;
+                break;
+            }
+        }
+
+        if (!satisfied && lbd <= KEEP_LBD) {
+            // Moving clauses down never overwrites one that is not moved yet
+            for (int i = 0; i < CLAUSE_HEADER + size; i++) {
+                clauses[kept + i] = clauses[clause + i];
+            }
+            pushInt(&solver->watches[clauses[kept + CLAUSE_HEADER]], kept);
+            pushInt(&solver->watches[clauses[kept + CLAUSE_HEADER + 1]], kept);
+            if (lbd > 0) {
+                solver->learnedCount++;
+            }
+            kept += CLAUSE_HEADER + size;
+        }
+        clause = next;
+    }
+    solver->clauses.count = kept;
+
+    for (int i = 0; i < solver->trailCount; i++) {
+        solver->reasons[LITERAL_VAR(solver->trail[i])] = NO_REASON;
+    }
+}
+
+/**
+ * Returns element i (starting from 0) of the Luby sequence
+ * 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8, ...
+ */
+static long luby(long i) {
+    long size = 1;
+    int power = 0;
+    while (size < i + 1) {
+        power++;
+        size = 2 * size + 1;
+    }
+    while (size - 1 != i) {
+        size = (size - 1) / 2;
+        power--;
+        i %= size;
+    }
+    return 1L << power;
+}
+
+/**
+ * Searches for an assignment that satisfies every clause. Gives up if
+ * cancel is set by another thread.
+ *
+ * Returns 0 if one was found, -1 if there is none or the search gave up
+ */
+static int solve(SatSolver* solver, int* cancel) {
+    if (propagate(solver) != NO_CONFLICT) {
+        return -1;
+    }
+
+    for (long restarts = 0; ; restarts++) {
+        if (cancel != NULL && __atomic_load_n(cancel, __ATOMIC_RELAXED)) {
+            return -1;
+        }
+
+        long conflictLimit = RESTART_BASE * luby(restarts);
+        while (conflictLimit > 0) {
+            int conflict = propagate(solver);
+            if (conflict != NO_CONFLICT) {
+                solver->conflicts++;
+                conflictLimit--;
+                if (decisionLevel(solver) == 0) {
+                    return -1;
+                }
+
+                int lbd = analyze(solver, conflict);
+                IntVector* learned = &solver->learned;
+                if (learned->count == 1) {
+                    backtrack(solver, 0);
+                    assign(solver, learned->items[0], NO_REASON);
+                }
+                else {
+                    backtrack(solver, solver->levels[LITERAL_VAR(learned->items[1])]);
+                    int clause = addClause(solver, learned->items, learned->count, lbd);
+                    solver->learnedCount++;
+                    assign(solver, learned->items[0], clause);
+                }
+                solver->activityIncrement /= ACTIVITY_DECAY;
+                continue;
+            }
+
+            // Decide on the most active variable that is not assigned yet
+            int var = -1;
+            while (solver->heapCount > 0) {
+                int candidate = heapRemoveMax(solver);
+                if (solver->values[candidate] == UNASSIGNED) {
+                    var = candidate;
+                    break;
+                }
+            }
+            if (var == -1) {
+                return 0;
+            }
+
+            solver->decisions++;
+            pushInt(&solver->levelStarts, solver->trailCount);
+            assign(solver, LITERAL(var, solver->phases[var] == FALSE), NO_REASON);
+        }
+
+        backtrack(solver, 0);
+        if (solver->learnedCount > solver->maxLearned) {
+            reduceClauses(solver);
+            solver->maxLearned += solver->maxLearned / 2;
+        }
+    }
+}
+
+static void createSolver(SatSolver* solver, int varCount) {
+    *solver = (SatSolver) {0};
+    solver->varCount = varCount;
+    solver->watches = allocate(2 * varCount * sizeof(IntVector));
+    for (int i = 0; i < 2 * varCount; i++) {
+        solver->watches[i] = (IntVector) {0};
+    }
+    solver->values = allocate(varCount);
+    solver->levels = allocate(varCount * sizeof(int));
+    solver->reasons = allocate(varCount * sizeof(int));
+    solver->phases = allocate(varCount);
+    solver->activity = allocate(varCount * sizeof(double));
+    solver->seen = allocate(varCount * sizeof(bool));
+    solver->trail = allocate(varCount * sizeof(int));
+    solver->heap = allocate(varCount * sizeof(int));
+    solver->heapIndex = allocate(varCount * sizeof(int));
+    // There is never a level above the number of variables
+    solver->levelStamps = allocate((varCount + 1) * sizeof(int));
+
+    for (int var = 0; var < varCount; var++) {
+        solver->values[var] = UNASSIGNED;
+        // Deciding that a tile has a value propagates much more than
+        // deciding that it does not
+        solver->phases[var] = TRUE;
+        solver->activity[var] = 0;
+        solver->seen[var] = false;
+        solver->heapIndex[var] = -1;
+        solver->levelStamps[var] = 0;
+    }
+    solver->levelStamps[varCount] = 0;
+    solver->activityIncrement = 1;
+    solver->maxLearned = INITIAL_MAX_LEARNED;
+}
+
+static void freeSolver(SatSolver* solver) {
+    for (int i = 0; i < 2 * solver->varCount; i++) {
+        free(solver->watches[i].items);
+    }
+    free(solver->watches);
+    free(solver->clauses.items);
+    free(solver->levelStarts.items);
+    free(solver->learned.items);
+    free(solver->values);
+    free(solver->levels);
+    free(solver->reasons);
+    free(solver->phases);
+    free(solver->activity);
+    free(solver->seen);
+    free(solver->trail);
+    free(solver->heap);
+    free(solver->heapIndex);
+    free(solver->levelStamps);
+}
+
+/**
+ * Adds clauses saying that exactly one of the variables is true
+ * Returns -1 if there are no variables, so none of them can be true
+ */
+static int addExactlyOne(SatSolver* solver, const int* vars, int count) {
+    if (count == 0) {
+        return -1;
+    }
+    if (count == 1) {
+        // Only true values are assigned before propagating, so the variable
+        // may already be true but never false
+        if (solver->values[vars[0]] == UNASSIGNED) {
+            assign(solver, LITERAL(vars[0], 0), NO_REASON);
+        }
+        return 0;
+    }
+
+    // count is at least 2 here, but gcc cannot tell that every literal
+    // addClause reads was set
+    int literals[BOARD_SIZE] = {0};
+    for (int i = 0; i < count; i++) {
+        literals[i] = LITERAL(vars[i], 0);
+    }
+    addClause(solver, literals, count, 0);
+
+    for (int i = 0; i < count; i++) {
+        for (int j = i + 1; j < count; j++) {
+            int pair[2] = {LITERAL(vars[i], 1), LITERAL(vars[j], 1)};
+            addClause(solver, pair, 2, 0);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Solves the board with the SAT engine
+ * Only options->cancel is used. stats (if not NULL) is filled with the
+ * statistics of the search, with every decision counted as a guess.
+ *
+ * Returns 0 if solving was successful, -1 otherwise
+ */
+int solveBoardSat(SudokuBoard* board, const SolverOptions* options, SolverStats* stats) {
+    SolverStats localStats;
+    if (stats == NULL) {
+        stats = &localStats;
+    }
+    *stats = (SolverStats) {0};
+
+    if (isDeadEndBoard(board)) {
+        return -1;
+    }
+    if (isCompleteBoard(board)) {
+        return 0;
+    }
+
+    // The variable of every possible value of every empty tile, -1 for
+    // values that are not possible
+    int tileVars[BOARD_CELLS][BOARD_SIZE];
+    int varCount = 0;
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        Tile* tile = &board->tiles[i];
+        for (int value = 1; value <= BOARD_SIZE; value++) {
+            bool possible = tile->value == 0 && (tile->possibleValues & CANDIDATE_BIT(value));
+            tileVars[i][value - 1] = possible ? varCount++ : -1;
+        }
+    }
+
+    SatSolver solver;
+    createSolver(&solver, varCount);
+
+    int result = 0;
+    int vars[BOARD_SIZE];
+    // Every empty tile has exactly one value
+    for (int i = 0; i < BOARD_CELLS && result == 0; i++) {
+        if (board->tiles[i].value != 0) {
+            continue;
+        }
+        int count = 0;
+        for (int value = 1; value <= BOARD_SIZE; value++) {
+            if (tileVars[i][value - 1] != -1) {
+                vars[count++] = tileVars[i][value - 1];
+                // Tiles with fewer possible values are decided on first
+                solver.activity[tileVars[i][value - 1]] = 1.0 / board->tiles[i].possibleCount;
+            }
+        }
+        result = addExactlyOne(&solver, vars, count);
+    }
+
+    // Every value missing from a row, column or box goes on exactly one of
+    // its tiles
+    for (int unit = 0; unit < 3 * BOARD_SIZE && result == 0; unit++) {
+        CandidateMask placed = unit < BOARD_SIZE ? board->rowValues[unit]
+            : unit < 2 * BOARD_SIZE ? board->colValues[unit - BOARD_SIZE]
+            : board->boxValues[unit - 2 * BOARD_SIZE];
+
+        for (int value = 1; value <= BOARD_SIZE && result == 0; value++) {
+            if (placed & CANDIDATE_BIT(value)) {
+                continue;
+            }
+            int count = 0;
+            for (int i = 0; i < BOARD_SIZE; i++) {
+                int var = tileVars[unitTile(unit, i)][value - 1];
+                if (var != -1) {
+                    vars[count++] = var;
+                }
+            }
+            result = addExactlyOne(&solver, vars, count);
+        }
+    }
+
+    for (int var = 0; var < varCount; var++) {
+        heapInsert(&solver, var);
+    }
+
+    if (result == 0) {
+        result = solve(&solver, options->cancel);
+    }
+    stats->guesses = solver.decisions;
+    stats->conflicts = solver.conflicts;
+
+    if (result == 0) {
+        for (int i = 0; i < BOARD_CELLS; i++) {
+            for (int value = 1; value <= BOARD_SIZE; value++) {
+                int var = tileVars[i][value - 1];
+                if (var != -1 && solver.values[var] == TRUE) {
+                    placeSudokuValue(board, i / BOARD_SIZE, i % BOARD_SIZE, value);
+                }
+            }
+        }
+        result = isCompleteBoard(board) ? 0 : -1;
+    }
+
+    freeSolver(&solver);
+    return result;
+}
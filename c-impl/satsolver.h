@@ -0,0 +1,9 @@
+#ifndef __SAT_SOLVER_DEFS
+#define __SAT_SOLVER_DEFS
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+
+int solveBoardSat(SudokuBoard*, const SolverOptions*, SolverStats*);
+
+#endif
@@ -0,0 +1,190 @@
+/**
+ * Solver sessions for interactive programs
+ *
+ * A session keeps a board that a player changes one tile at a time. The
+ * possible values of its tiles are kept up to date as values are placed
+ * and erased, so no move needs the board to be read or set up again.
+ *
+ * Whenever the board has to be solved, the solution is kept. A solution
+ * stays a solution when a value is erased and when the value it has on a
+ * tile is placed there, and a board without a solution never gets one by
+ * placing more values, so most moves do not need the board to be solved
+ * again.
+ */
+#include "sudoku.h"
+#include "puzzlesolver.h"
+#include "session.h"
+
+/**
+ * Starts a session with the given board. The values on the board become
+ * the givens of the session.
+ */
+void startSolverSession(SolverSession* session, SudokuBoard* board) {
+    copySudokuBoard(board, &session->board);
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        session->givens[i] = board->tiles[i].value != 0;
+    }
+    session->solutionState = SOLUTION_UNKNOWN;
+    session->solves = 0;
+}
+
+/**
+ * Places a value on a tile that is not a given, replacing its value if it
+ * has one. Values that break the rules can be placed; the board is then no
+ * longer solvable.
+ *
+ * Returns 0 if the value was placed, -1 if the tile is a given or the value
+ * is out of range
+ */
+int placeSessionValue(SolverSession* session, int row_i, int col_i, short value) {
+    int index = row_i * BOARD_SIZE + col_i;
+    if (session->givens[index] || value < 1 || value > BOARD_SIZE) {
+        return -1;
+    }
+
+    if (session->board.tiles[index].value != 0) {
+        eraseSessionValue(session, row_i, col_i);
+    }
+    placeSudokuValue(&session->board, row_i, col_i, value);
+
+    if (session->solutionState == SOLUTION_FOUND && session->solution[index] != value) {
+        session->solutionState = SOLUTION_UNKNOWN;
+    }
+    return 0;
+}
+
+/**
+ * Erases the value of a tile that is not a given
+ *
+ * Returns 0 if the tile is empty now, -1 if it is a given
+ */
+int eraseSessionValue(SolverSession* session, int row_i, int col_i) {
+    int index = row_i * BOARD_SIZE + col_i;
+    if (session->givens[index]) {
+        return -1;
+    }
+    if (session->board.tiles[index].value == 0) {
+        return 0;
+    }
+
+    eraseSudokuValue(&session->board, row_i, col_i);
+
+    // A solution is still a solution with fewer values on the board, but a
+    // board without one may have one now
+    if (session->solutionState == SOLUTION_NONE) {
+        session->solutionState = SOLUTION_UNKNOWN;
+    }
+    return 0;
+}
+
+/**
+ * Solves the board unless it is already known whether it has a solution
+ */
+static void updateSolution(SolverSession* session) {
+    if (session->solutionState != SOLUTION_UNKNOWN) {
+        return;
+    }
+
+    session->solves++;
+    SudokuBoard copy;
+    copySudokuBoard(&session->board, &copy);
+    if (isDeadEndBoard(&copy) || solveBoard(&copy) == -1) {
+        session->solutionState = SOLUTION_NONE;
+        return;
+    }
+    getBoardValues(&copy, session->solution);
+    session->solutionState = SOLUTION_FOUND;
+}
+
+/**
+ * Returns whether the board can still be solved with the values placed on
+ * it so far
+ */
+bool isSessionSolvable(SolverSession* session) {
+    updateSolution(session);
+    return session->solutionState == SOLUTION_FOUND;
+}
+
+/**
+ * Fills solution with a solution of the board
+ *
+ * Returns 0 if the board has a solution, -1 otherwise
+ */
+int getSessionSolution(SolverSession* session, SudokuBoard* solution) {
+    updateSolution(session);
+    if (session->solutionState != SOLUTION_FOUND) {
+        return -1;
+    }
+
+    emptySudokuBoard(solution);
+    setSolvedBoardValues(solution, session->solution);
+    return 0;
+}
+
+/**
+ * Finds a value that can only go on one tile of a row, column or box
+ * Returns the index of the tile or -1 if there is no such value
+ */
+static int findHiddenSingle(SudokuBoard* board, short* value) {
+    for (int unit = 0; unit < 3 * BOARD_SIZE; unit++) {
+        // The values that can go on at least one and on more than one tile
+        CandidateMask once = 0;
+        CandidateMask twice = 0;
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            Tile* tile = &board->tiles[unitTile(unit, i)];
+            if (tile->value == 0) {
+                twice |= once & tile->possibleValues;
+                once |= tile->possibleValues;
+            }
+        }
+
+        CandidateMask single = once & ~twice;
+        if (single == 0) {
+            continue;
+        }
+        *value = lowestCandidate(single);
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            int index = unitTile(unit, i);
+            if (board->tiles[index].value == 0
+                    && (board->tiles[index].possibleValues & CANDIDATE_BIT(*value))) {
+                return index;
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * Finds the next value to place as a hint. Singles are preferred since they
+ * follow from the board; otherwise the value of the tile with the fewest
+ * possible values is taken from the solution.
+ *
+ * Returns 0 if a step was found, -1 if the board is complete or has no
+ * solution
+ */
+int findNextSessionStep(SolverSession* session, SessionStep* step) {
+    SudokuBoard* board = &session->board;
+    if (board->emptyCount == 0 || !isSessionSolvable(session)) {
+        return -1;
+    }
+
+    int index = firstTileInSet(&board->tilesByCount[1]);
+    if (index != -1) {
+        step->kind = STEP_NAKED_SINGLE;
+        step->value = lowestCandidate(board->tiles[index].possibleValues);
+    }
+    else if ((index = findHiddenSingle(board, &step->value)) != -1) {
+        step->kind = STEP_HIDDEN_SINGLE;
+    }
+    else {
+        for (int count = 2; count <= BOARD_SIZE && index == -1; count++) {
+            index = firstTileInSet(&board->tilesByCount[count]);
+        }
+        step->kind = STEP_FROM_SOLUTION;
+        step->value = session->solution[index];
+    }
+
+    step->row_i = index / BOARD_SIZE;
+    step->col_i = index % BOARD_SIZE;
+    return 0;
+}
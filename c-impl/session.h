@@ -0,0 +1,52 @@
+#ifndef __SESSION_DEFS
+#define __SESSION_DEFS
+
+#include "sudoku.h"
+
+// What is known about the solutions of a session's board
+typedef enum {
+    SOLUTION_UNKNOWN,
+    SOLUTION_FOUND,
+    SOLUTION_NONE,
+} SolutionState;
+
+typedef struct {
+    // The board with every move made so far
+    SudokuBoard board;
+    // The tiles that were filled in when the session started. These cannot
+    // be changed.
+    bool givens[BOARD_CELLS];
+    SolutionState solutionState;
+    // A solution of the board if solutionState is SOLUTION_FOUND
+    unsigned char solution[BOARD_CELLS];
+    // The number of times the board had to be solved. Every other question
+    // was answered with what was already known.
+    long solves;
+} SolverSession;
+
+// How a step was found
+typedef enum {
+    // The tile has only one possible value left
+    STEP_NAKED_SINGLE,
+    // The value can only go on this tile of one of its rows, columns or
+    // boxes
+    STEP_HIDDEN_SINGLE,
+    // No single was left, so the value was taken from the solution
+    STEP_FROM_SOLUTION,
+} StepKind;
+
+typedef struct {
+    StepKind kind;
+    int row_i;
+    int col_i;
+    short value;
+} SessionStep;
+
+void startSolverSession(SolverSession*, SudokuBoard*);
+int placeSessionValue(SolverSession*, int, int, short);
+int eraseSessionValue(SolverSession*, int, int);
+bool isSessionSolvable(SolverSession*);
+int getSessionSolution(SolverSession*, SudokuBoard*);
+int findNextSessionStep(SolverSession*, SessionStep*);
+
+#endif
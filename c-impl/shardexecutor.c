@@ -0,0 +1,260 @@
+/**
+ * The executors that shardsudoku can run its workers with
+ *
+ * An executor is given each shard as a job: a command, the part of the
+ * input file it reads and the files its output and errors go to. How and
+ * where the command runs is up to the executor, so an executor for other
+ * machines only needs to move the input there and the output back.
+ *
+ * The local executor runs every job as two child processes: the worker and
+ * a feeder that writes its part of the input file into a pipe that is the
+ * standard input of the worker. No copy of the input is ever written to
+ * disk.
+ */
+#if __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 600
+#else
+#define _XOPEN_SOURCE 500
+#endif /* __STDC_VERSION__ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h> // calloc, free, EXIT_FAILURE, EXIT_SUCCESS
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "shardexecutor.h"
+
+// The exit status of a worker that could not be started, like a shell uses
+#define EXEC_FAILED 127
+
+typedef struct {
+    pid_t worker;
+    pid_t feeder;
+    bool workerDone;
+    bool feederDone;
+    bool failed;
+} LocalJob;
+
+typedef struct {
+    int jobCount;
+    int running;
+    LocalJob* jobs;
+} LocalExecutor;
+
+static void* createLocalExecutor(int jobCount) {
+    LocalExecutor* executor = malloc(sizeof(LocalExecutor));
+    if (executor == NULL) {
+        return NULL;
+    }
+    executor->jobs = calloc(jobCount, sizeof(LocalJob));
+    if (executor->jobs == NULL) {
+        free(executor);
+        return NULL;
+    }
+    executor->jobCount = jobCount;
+    executor->running = 0;
+    return executor;
+}
+
+static void freeLocalExecutor(void* state) {
+    LocalExecutor* executor = state;
+    free(executor->jobs);
+    free(executor);
+}
+
+/**
+ * Writes path from start up to end to fd
+ *
+ * Returns 0 if successful, -1 otherwise
+ */
+static int feedInput(const char* path, long start, long end, int fd) {
+    int input = open(path, O_RDONLY);
+    if (input == -1 || lseek(input, start, SEEK_SET) == -1) {
+        perror(path);
+        return -1;
+    }
+
+    char buffer[1 << 16];
+    while (start < end) {
+        long wanted = end - start < (long)sizeof(buffer) ? end - start : (long)sizeof(buffer);
+        ssize_t count = read(input, buffer, wanted);
+        if (count == -1 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            fprintf(stderr, "%s: unable to read the input of the shard\n", path);
+            return -1;
+        }
+        start += count;
+
+        for (ssize_t written = 0; written < count;) {
+            ssize_t size = write(fd, buffer + written, count - written);
+            if (size == -1 && errno != EINTR) {
+                perror("write");
+                return -1;
+            }
+            written += size > 0 ? size : 0;
+        }
+    }
+    close(input);
+    return 0;
+}
+
+/**
+ * Points the standard input, output and error of the current process at
+ * the given file descriptor and files and runs the worker of the job
+ * instead of the current program. Only returns if that fails.
+ */
+static void execWorker(const ShardJob* job, int input) {
+    int output = open(job->outputPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (output == -1) {
+        perror(job->outputPath);
+        return;
+    }
+    int errors = open(job->errorPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (errors == -1) {
+        perror(job->errorPath);
+        return;
+    }
+    if (dup2(input, STDIN_FILENO) == -1 || dup2(output, STDOUT_FILENO) == -1 || dup2(errors, STDERR_FILENO) == -1) {
+        perror("dup2");
+        return;
+    }
+    close(input);
+    close(output);
+    close(errors);
+
+    execvp(job->argv[0], job->argv);
+    // This goes to the error file of the job
+    perror(job->argv[0]);
+}
+
+static int startLocalJob(void* state, const ShardJob* job) {
+    LocalExecutor* executor = state;
+
+    int fds[2];
+    if (pipe(fds) == -1) {
+        perror("pipe");
+        return -1;
+    }
+
+    pid_t feeder = fork();
+    if (feeder == 0) {
+        close(fds[0]);
+        _exit(feedInput(job->inputPath, job->inputStart, job->inputEnd, fds[1]) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    pid_t worker = feeder == -1 ? -1 : fork();
+    if (worker == 0) {
+        close(fds[1]);
+        execWorker(job, fds[0]);
+        _exit(EXEC_FAILED);
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+    if (worker == -1) {
+        perror("fork");
+        if (feeder != -1) {
+            // Nothing reads the pipe anymore, so the feeder stops on its own
+            waitpid(feeder, NULL, 0);
+        }
+        return -1;
+    }
+
+    LocalJob* local = &executor->jobs[job->index];
+    local->worker = worker;
+    local->feeder = feeder;
+    local->workerDone = false;
+    local->feederDone = false;
+    local->failed = false;
+    executor->running++;
+    return 0;
+}
+
+/**
+ * Returns true if a process exited with the status EXIT_SUCCESS
+ */
+static bool exitedSuccessfully(int status) {
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+static int waitLocalJob(void* state, int* status) {
+    LocalExecutor* executor = state;
+
+    while (executor->running > 0) {
+        int processStatus;
+        pid_t pid = waitpid(-1, &processStatus, 0);
+        if (pid == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("waitpid");
+            return -1;
+        }
+
+        for (int i = 0; i < executor->jobCount; i++) {
+            LocalJob* job = &executor->jobs[i];
+            if (pid == job->worker && !job->workerDone) {
+                job->workerDone = true;
+                job->failed |= !exitedSuccessfully(processStatus);
+            }
+            else if (pid == job->feeder && !job->feederDone) {
+                job->feederDone = true;
+                // A worker that stops reading early (after an invalid board)
+                // ends its feeder with SIGPIPE. The worker's own status
+                // tells whether that was a failure.
+                bool stoppedByReader = WIFSIGNALED(processStatus) && WTERMSIG(processStatus) == SIGPIPE;
+                job->failed |= !exitedSuccessfully(processStatus) && !stoppedByReader;
+            }
+            else {
+                continue;
+            }
+
+            if (job->workerDone && job->feederDone) {
+                executor->running--;
+                *status = job->failed ? -1 : 0;
+                return i;
+            }
+            break;
+        }
+    }
+    return -1;
+}
+
+static const ShardExecutor executors[] = {
+    // Child processes on this machine
+    {"local", createLocalExecutor, startLocalJob, waitLocalJob, freeLocalExecutor},
+};
+
+#define EXECUTOR_COUNT ((int)(sizeof(executors) / sizeof(executors[0])))
+
+const ShardExecutor* const defaultShardExecutor = &executors[0];
+
+/**
+ * Returns the executor with the given name or NULL if there is no such
+ * executor
+ */
+const ShardExecutor* findShardExecutor(const char* name) {
+    for (int i = 0; i < EXECUTOR_COUNT; i++) {
+        if (strcmp(executors[i].name, name) == 0) {
+            return &executors[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Writes the names of every executor separated by '|' (for usage messages)
+ */
+void printShardExecutorNames(FILE* file) {
+    for (int i = 0; i < EXECUTOR_COUNT; i++) {
+        fprintf(file, i == 0 ? "%s" : "|%s", executors[i].name);
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef __SHARD_EXECUTOR_DEFS
+#define __SHARD_EXECUTOR_DEFS
+
+#include <stdio.h>
+
+typedef struct {
+    // Which shard this is, from 0 for the start of the input
+    int index;
+    // The worker command, ending with NULL
+    char* const* argv;
+    // The worker reads inputPath from inputStart up to (not including)
+    // inputEnd as its standard input
+    const char* inputPath;
+    long inputStart;
+    long inputEnd;
+    // The files that the standard output and error of the worker end up in
+    const char* outputPath;
+    const char* errorPath;
+} ShardJob;
+
+typedef struct {
+    // The name used to pick the executor on the command line
+    const char* name;
+    // Creates the state of a run of jobs with indexes below the given count,
+    // returns NULL if it could not be created
+    void* (*create)(int);
+    // Starts the job, returns 0 if successful, -1 otherwise
+    int (*start)(void*, const ShardJob*);
+    // Waits for any started job to finish and sets the status to 0 if it
+    // succeeded or -1 if it failed. Returns the index of the job or -1 if no
+    // job is running.
+    int (*wait)(void*, int*);
+    void (*free)(void*);
+} ShardExecutor;
+
+extern const ShardExecutor* const defaultShardExecutor;
+
+const ShardExecutor* findShardExecutor(const char*);
+void printShardExecutorNames(FILE*);
+
+#endif
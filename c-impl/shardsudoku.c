@@ -0,0 +1,359 @@
+/**
+ * Runs solvesudoku, timesolvesudoku or any other program that reads boards
+ * from stdin over a large input file with several independent processes
+ *
+ * The input file is split into shards of about the same size, always
+ * between two boards, and every shard is given to its own worker through
+ * an executor (see shardexecutor.c). Once every worker is done, their
+ * outputs are written to stdout one after another in the order of the
+ * input, so the output is the same as running the program on the whole
+ * file (apart from timings). With --csv, the first line of every output
+ * is a header that is only written once. The errors of every worker are
+ * written to stderr, prefixed with their shard.
+ *
+ * Every worker runs the same command, so a --store passed through to them
+ * is rejected: a solution store only allows one process to write to it (see
+ * solutionstore.c), so every worker but one would fail to open it.
+ *
+ * Usage: shardsudoku [--shards n] [--jobs n] [--executor name] [--workdir dir]
+ *                    [--csv] [--keep] input program [arguments...]
+ *
+ * e.g. shardsudoku --shards 8 --csv puzzles.txt ./timesolvesudoku > times.csv
+ */
+#if __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 600
+#else
+#define _XOPEN_SOURCE 500
+#endif /* __STDC_VERSION__ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h> // atoi, getenv, EXIT_FAILURE, EXIT_SUCCESS
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "sudoku.h"
+#include "shardexecutor.h"
+
+static void printUsage(char* program) {
+    fprintf(stderr, "Usage: %s [--shards n] [--jobs n] [--executor ", program);
+    printShardExecutorNames(stderr);
+    fprintf(stderr, "] [--workdir dir]\n"
+        "\t[--csv] [--keep] input program [arguments...]\n");
+}
+
+/**
+ * Returns where the next board starts after the one that starts at offset.
+ * Boards are told apart like boardreader.c does: a first line of BOARD_SIZE
+ * characters starts a board of BOARD_SIZE lines and any other line is a
+ * whole board.
+ */
+static long skipBoard(const char* text, long size, long offset) {
+    long lines = 1;
+    for (long line = 0; line < lines; line++) {
+        const char* newline = memchr(text + offset, '\n', size - offset);
+        if (newline == NULL) {
+            return size;
+        }
+        if (line == 0 && newline - (text + offset) == BOARD_SIZE) {
+            lines = BOARD_SIZE;
+        }
+        offset = newline - text + 1;
+    }
+    return offset;
+}
+
+/**
+ * Splits the text of the boards into shards of about the same size that
+ * start and end between boards. Shard i is text[bounds[i]] up to
+ * text[bounds[i + 1]], so bounds has one more entry than there are shards.
+ * Shards are empty if there are fewer boards than shards.
+ */
+static void splitBoards(const char* text, long size, int shards, long* bounds) {
+    long offset = 0;
+    bounds[0] = 0;
+    for (int i = 1; i < shards; i++) {
+        long target = (long)((double)size * i / shards);
+        while (offset < target) {
+            offset = skipBoard(text, size, offset);
+        }
+        bounds[i] = offset;
+    }
+    bounds[shards] = size;
+}
+
+/**
+ * Returns true if the text starts with the magic number of gzip or zstd,
+ * the formats read by compressedstream.c
+ */
+static bool isCompressed(const unsigned char* text, long size) {
+    static const unsigned char gzipMagic[] = {0x1f, 0x8b};
+    static const unsigned char zstdMagic[] = {0x28, 0xb5, 0x2f, 0xfd};
+    return (size >= (long)sizeof(gzipMagic) && memcmp(text, gzipMagic, sizeof(gzipMagic)) == 0)
+        || (size >= (long)sizeof(zstdMagic) && memcmp(text, zstdMagic, sizeof(zstdMagic)) == 0);
+}
+
+/**
+ * Finds where every shard of the file at path starts and ends
+ *
+ * Returns 0 if successful, -1 if the file could not be read
+ */
+static int findShardBounds(const char* path, int shards, long* bounds) {
+    int fd = open(path, O_RDONLY);
+    struct stat status;
+    if (fd == -1 || fstat(fd, &status) == -1) {
+        perror(path);
+        return -1;
+    }
+    if (status.st_size == 0) {
+        memset(bounds, 0, (shards + 1) * sizeof(long));
+        close(fd);
+        return 0;
+    }
+
+    char* text = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+
+    // The boards of compressed files cannot be found without decompressing
+    // them first
+    if (isCompressed((const unsigned char*)text, status.st_size)) {
+        fprintf(stderr, "%s: compressed input cannot be split, decompress it first\n", path);
+        munmap(text, status.st_size);
+        return -1;
+    }
+
+    splitBoards(text, status.st_size, shards, bounds);
+    munmap(text, status.st_size);
+    return 0;
+}
+
+/**
+ * Copies the file at path to stdout, without its first line if skipHeader
+ * is true
+ *
+ * Returns 0 if successful, -1 otherwise
+ */
+static int appendOutput(const char* path, bool skipHeader) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    if (skipHeader) {
+        int c;
+        while ((c = getc(fp)) != EOF && c != '\n') {
+        }
+    }
+
+    char buffer[1 << 16];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        fwrite(buffer, 1, size, stdout);
+    }
+    bool failed = ferror(fp);
+    fclose(fp);
+    return failed ? -1 : 0;
+}
+
+/**
+ * Copies the file at path to stderr with every line prefixed by the shard
+ */
+static void appendErrors(const char* path, int shard) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return;
+    }
+
+    bool lineStart = true;
+    int c;
+    while ((c = getc(fp)) != EOF) {
+        if (lineStart) {
+            fprintf(stderr, "shard %d: ", shard);
+        }
+        putc(c, stderr);
+        lineStart = c == '\n';
+    }
+    if (!lineStart) {
+        putc('\n', stderr);
+    }
+    fclose(fp);
+}
+
+int main(int argc, char* argv[]) {
+    long shards = sysconf(_SC_NPROCESSORS_ONLN);
+    int jobs = 0;
+    const ShardExecutor* executor = defaultShardExecutor;
+    const char* workdir = NULL;
+    bool csv = false;
+    bool keep = false;
+
+    int i = 1;
+    for (; i < argc && strncmp(argv[i], "--", 2) == 0; i++) {
+        if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            shards = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--executor") == 0 && i + 1 < argc) {
+            executor = findShardExecutor(argv[++i]);
+            if (executor == NULL) {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--workdir") == 0 && i + 1 < argc) {
+            workdir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        }
+        else if (strcmp(argv[i], "--keep") == 0) {
+            keep = true;
+        }
+        else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    // The input and at least the program to run
+    if (argc - i < 2 || shards < 1 || jobs < 0) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char* inputPath = argv[i];
+    char* const* command = argv + i + 1;
+    for (int arg = i + 2; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--store") == 0) {
+            fprintf(stderr, "--store cannot be shared by the workers, run without it\n");
+            return EXIT_FAILURE;
+        }
+    }
+    if (jobs == 0 || jobs > shards) {
+        jobs = shards;
+    }
+
+    long* bounds = malloc((shards + 1) * sizeof(long));
+    if (bounds == NULL) {
+        fprintf(stderr, "Unable to allocate the shards\n");
+        return EXIT_FAILURE;
+    }
+    if (findShardBounds(inputPath, shards, bounds) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    // The outputs of the workers are kept in a directory of their own
+    bool createdWorkdir = false;
+    char defaultWorkdir[4096];
+    if (workdir == NULL) {
+        const char* temp = getenv("TMPDIR");
+        snprintf(defaultWorkdir, sizeof(defaultWorkdir), "%s/shardsudoku.%ld",
+            temp != NULL ? temp : "/tmp", (long)getpid());
+        workdir = defaultWorkdir;
+        if (mkdir(workdir, 0700) == -1) {
+            perror(workdir);
+            return EXIT_FAILURE;
+        }
+        createdWorkdir = true;
+    }
+
+    size_t pathSize = strlen(workdir) + 32;
+    char (*outputPaths)[pathSize] = malloc(shards * pathSize);
+    char (*errorPaths)[pathSize] = malloc(shards * pathSize);
+    bool* started = calloc(shards, sizeof(bool));
+    void* state = executor->create(shards);
+    if (outputPaths == NULL || errorPaths == NULL || started == NULL || state == NULL) {
+        fprintf(stderr, "Unable to allocate the shards\n");
+        return EXIT_FAILURE;
+    }
+    for (int shard = 0; shard < shards; shard++) {
+        snprintf(outputPaths[shard], pathSize, "%s/shard-%d.out", workdir, shard);
+        snprintf(errorPaths[shard], pathSize, "%s/shard-%d.err", workdir, shard);
+    }
+
+    // Up to jobs workers run at a time. Shards without boards are skipped.
+    int failures = 0;
+    int running = 0;
+    int next = 0;
+    while (true) {
+        while (running < jobs && next < shards) {
+            int shard = next++;
+            if (bounds[shard] == bounds[shard + 1]) {
+                continue;
+            }
+
+            ShardJob job = {shard, command, inputPath, bounds[shard], bounds[shard + 1],
+                outputPaths[shard], errorPaths[shard]};
+            if (executor->start(state, &job) == -1) {
+                fprintf(stderr, "Unable to start shard %d\n", shard);
+                failures++;
+                continue;
+            }
+            started[shard] = true;
+            running++;
+        }
+
+        int status;
+        int shard = executor->wait(state, &status);
+        if (shard == -1) {
+            break;
+        }
+        running--;
+        if (status == -1) {
+            fprintf(stderr, "Shard %d failed (see %s)\n", shard, errorPaths[shard]);
+            failures++;
+        }
+    }
+    executor->free(state);
+
+    for (int shard = 0; shard < shards; shard++) {
+        if (started[shard]) {
+            appendErrors(errorPaths[shard], shard);
+        }
+    }
+
+    // A partial output would look complete, so nothing is written unless
+    // every shard succeeded
+    if (failures == 0) {
+        bool headerWritten = false;
+        for (int shard = 0; shard < shards; shard++) {
+            if (!started[shard]) {
+                continue;
+            }
+            if (appendOutput(outputPaths[shard], csv && headerWritten) == -1) {
+                failures++;
+            }
+            headerWritten = true;
+        }
+        fflush(stdout);
+    }
+
+    if (failures > 0 || keep) {
+        fprintf(stderr, "The output of every shard is in %s\n", workdir);
+    }
+    else {
+        for (int shard = 0; shard < shards; shard++) {
+            if (started[shard]) {
+                unlink(outputPaths[shard]);
+                unlink(errorPaths[shard]);
+            }
+        }
+        if (createdWorkdir) {
+            rmdir(workdir);
+        }
+    }
+
+    free(bounds);
+    free(outputPaths);
+    free(errorPaths);
+    free(started);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,256 @@
+/**
+ * A size bounded, thread safe cache of solved boards
+ *
+ * Boards are stored by their canonical form (see boardtransform.c) so a
+ * board is answered from the cache if it or any board equivalent to it
+ * was solved before. Boards are also stored exactly as they were given so
+ * boards that repeat verbatim do not need to be canonicalized again.
+ *
+ * The cache is split into independently locked shards. Each shard is a set
+ * associative table: a board can only be stored in one of CACHE_WAYS
+ * entries of the set its hash selects, and the least recently used entry of
+ * that set is replaced when it is full.
+ */
+#include <stdlib.h> // calloc, free
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "sudoku.h"
+#include "boardtransform.h"
+#include "puzzlesolver.h"
+#include "solverengine.h"
+#include "solutioncache.h"
+
+#define CACHE_SHARDS 64
+#define CACHE_WAYS 8
+
+typedef struct {
+    // 0 marks an unused entry
+    uint64_t hash;
+    // Shard clock value when the entry was last used
+    uint64_t lastUsed;
+    unsigned char givens[BOARD_CELLS];
+    unsigned char solution[BOARD_CELLS];
+} CacheEntry;
+
+typedef struct {
+    pthread_mutex_t lock;
+    uint64_t clock;
+    long hits;
+    long misses;
+    CacheEntry* entries;
+    // Keeps shards that are next to each other from sharing a cache line
+    char padding[64];
+} CacheShard;
+
+struct SolutionCache {
+    // Number of sets in every shard
+    long sets;
+    CacheShard shards[CACHE_SHARDS];
+};
+
+/**
+ * Hashes the given board values. Never returns 0.
+ */
+static uint64_t hashValues(const unsigned char values[BOARD_CELLS]) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        hash ^= values[i];
+        hash *= 1099511628211ull;
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+/**
+ * Creates a cache that holds at least the given number of solutions
+ *
+ * Returns NULL if memory could not be allocated
+ */
+SolutionCache* createSolutionCache(long capacity) {
+    SolutionCache* cache = calloc(1, sizeof(SolutionCache));
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    long perShard = (capacity + CACHE_SHARDS - 1) / CACHE_SHARDS;
+    cache->sets = (perShard + CACHE_WAYS - 1) / CACHE_WAYS;
+    if (cache->sets < 1) {
+        cache->sets = 1;
+    }
+
+    // Every lock is initialized first so that freeSolutionCache can destroy
+    // all of them if an allocation fails
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        pthread_mutex_init(&cache->shards[i].lock, NULL);
+    }
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        CacheShard* shard = &cache->shards[i];
+        shard->entries = calloc(cache->sets * CACHE_WAYS, sizeof(CacheEntry));
+        if (shard->entries == NULL) {
+            freeSolutionCache(cache);
+            return NULL;
+        }
+    }
+
+    return cache;
+}
+
+void freeSolutionCache(SolutionCache* cache) {
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        pthread_mutex_destroy(&cache->shards[i].lock);
+        free(cache->shards[i].entries);
+    }
+    free(cache);
+}
+
+static CacheShard* shardFor(SolutionCache* cache, uint64_t hash) {
+    return &cache->shards[hash >> 58];
+}
+
+static CacheEntry* setFor(SolutionCache* cache, CacheShard* shard, uint64_t hash) {
+    return &shard->entries[(hash % cache->sets) * CACHE_WAYS];
+}
+
+/**
+ * Looks up the solution of the given board
+ *
+ * Returns true and fills solution if the board was found
+ */
+static bool lookupSolution(SolutionCache* cache, uint64_t hash,
+        const unsigned char givens[BOARD_CELLS], unsigned char solution[BOARD_CELLS]) {
+    CacheShard* shard = shardFor(cache, hash);
+    CacheEntry* set = setFor(cache, shard, hash);
+    bool found = false;
+
+    pthread_mutex_lock(&shard->lock);
+    for (int i = 0; i < CACHE_WAYS; i++) {
+        CacheEntry* entry = &set[i];
+        if (entry->hash == hash && memcmp(entry->givens, givens, BOARD_CELLS) == 0) {
+            entry->lastUsed = ++shard->clock;
+            memcpy(solution, entry->solution, BOARD_CELLS);
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    return found;
+}
+
+/**
+ * Records whether a board was answered from the cache
+ */
+static void countResult(SolutionCache* cache, uint64_t hash, bool hit) {
+    CacheShard* shard = shardFor(cache, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    if (hit) {
+        shard->hits++;
+    }
+    else {
+        shard->misses++;
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/**
+ * Stores the solution of the given board, replacing the least
+ * recently used entry of its set
+ */
+static void storeSolution(SolutionCache* cache, uint64_t hash,
+        const unsigned char givens[BOARD_CELLS], const unsigned char solution[BOARD_CELLS]) {
+    CacheShard* shard = shardFor(cache, hash);
+    CacheEntry* set = setFor(cache, shard, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    CacheEntry* victim = &set[0];
+    for (int i = 0; i < CACHE_WAYS; i++) {
+        CacheEntry* entry = &set[i];
+        if (entry->hash == hash && memcmp(entry->givens, givens, BOARD_CELLS) == 0) {
+            // Another thread stored it first
+            victim = entry;
+            break;
+        }
+        if (entry->lastUsed < victim->lastUsed) {
+            victim = entry;
+        }
+    }
+
+    victim->hash = hash;
+    victim->lastUsed = ++shard->clock;
+    memcpy(victim->givens, givens, BOARD_CELLS);
+    memcpy(victim->solution, solution, BOARD_CELLS);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/**
+ * Solves the board, using and filling the cache
+ * Boards that are not in the cache are solved with the given engine
+ * Boards without a solution are not cached
+ *
+ * Boards are first looked up exactly as given so repeated boards skip
+ * computing the canonical form. Boards found through their canonical form
+ * are then also stored as given.
+ *
+ * Returns 0 if solving was successful, -1 otherwise
+ */
+int solveBoardCached(SolutionCache* cache, const SolverEngine* engine, SudokuBoard* board) {
+    unsigned char values[BOARD_CELLS];
+    unsigned char canonical[BOARD_CELLS];
+    unsigned char solution[BOARD_CELLS];
+    unsigned char solved[BOARD_CELLS];
+    BoardTransform transform;
+
+    getBoardValues(board, values);
+    uint64_t hash = hashValues(values);
+
+    if (lookupSolution(cache, hash, values, solution)) {
+        countResult(cache, hash, true);
+        setSolvedBoardValues(board, solution);
+        return 0;
+    }
+
+    canonicalizeBoard(values, canonical, &transform);
+    bool isCanonical = memcmp(values, canonical, BOARD_CELLS) == 0;
+    uint64_t canonicalHash = isCanonical ? hash : hashValues(canonical);
+
+    if (!isCanonical && lookupSolution(cache, canonicalHash, canonical, solution)) {
+        countResult(cache, hash, true);
+        invertBoardTransform(&transform, solution, solved);
+        storeSolution(cache, hash, values, solved);
+        setSolvedBoardValues(board, solved);
+        return 0;
+    }
+
+    countResult(cache, hash, false);
+
+    if (engine->solve(board, &defaultSolverOptions, NULL) == -1) {
+        return -1;
+    }
+
+    getBoardValues(board, solved);
+    applyBoardTransform(&transform, solved, solution);
+    storeSolution(cache, canonicalHash, canonical, solution);
+    if (!isCanonical) {
+        storeSolution(cache, hash, values, solved);
+    }
+
+    return 0;
+}
+
+/**
+ * Adds up the hit and miss counts of every shard
+ */
+void getSolutionCacheStats(SolutionCache* cache, SolutionCacheStats* stats) {
+    stats->hits = 0;
+    stats->misses = 0;
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        CacheShard* shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        stats->hits += shard->hits;
+        stats->misses += shard->misses;
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
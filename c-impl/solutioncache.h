@@ -0,0 +1,20 @@
+#ifndef __SOLUTION_CACHE_DEFS
+#define __SOLUTION_CACHE_DEFS
+
+#include "sudoku.h"
+#include "solverengine.h"
+
+typedef struct SolutionCache SolutionCache;
+
+typedef struct {
+    long hits;
+    long misses;
+} SolutionCacheStats;
+
+SolutionCache* createSolutionCache(long);
+void freeSolutionCache(SolutionCache*);
+
+int solveBoardCached(SolutionCache*, const SolverEngine*, SudokuBoard*);
+void getSolutionCacheStats(SolutionCache*, SolutionCacheStats*);
+
+#endif
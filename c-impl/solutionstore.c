@@ -0,0 +1,549 @@
+/**
+ * A persistent store of solved boards
+ *
+ * The store is made of two files:
+ *
+ * <path>.data - An append-only list of records. Each record is a packed
+ *  board followed by its packed solution.
+ * <path>.index - An open addressing hash table from packed boards to
+ *  record numbers.
+ *
+ * Both files are memory mapped, so looking up a solution does not copy
+ * anything out of the store. The index can always be rebuilt from the data
+ * file, so it is repaired or rebuilt whenever it does not match the data.
+ *
+ * A store may be shared by many readers, but only one process may write to
+ * it at a time. Writers hold an exclusive lock (flock) on the data file while
+ * the store is open, so a second writer fails to open it instead of
+ * corrupting the index.
+ */
+
+#if __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 600
+#else
+#define _XOPEN_SOURCE 500
+#endif /* __STDC_VERSION__ */
+
+#include <stdio.h>
+#include <stdlib.h> // malloc, free
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+#include "solverengine.h"
+#include "solutioncache.h"
+#include "solutionstore.h"
+
+#define DATA_MAGIC "SUDSTORE"
+#define INDEX_MAGIC "SUDINDEX"
+#define STORE_VERSION 1
+
+#define RECORD_BYTES (2 * PACKED_BOARD_BYTES)
+// Index slots are always a power of two and at most half full
+#define MIN_INDEX_SLOTS 1024
+// The data file is mapped in chunks of at least this many bytes so that
+// appending does not require remapping every time
+#define MIN_DATA_MAPPING (1 << 20)
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t boardSize;
+} DataHeader;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t boardSize;
+    uint64_t slots;
+    // The number of data records that have been added to the index
+    uint64_t records;
+} IndexHeader;
+
+typedef struct {
+    // The upper half of the hash of the packed board
+    uint32_t tag;
+    // 1 + the record number, 0 marks an empty slot
+    uint32_t record;
+} IndexSlot;
+
+struct SolutionStore {
+    bool writable;
+
+    int dataFd;
+    unsigned char* data;
+    size_t dataMapped;
+    uint64_t records;
+
+    char* indexPath;
+    int indexFd;
+    IndexHeader* index;
+    size_t indexMapped;
+};
+
+/**
+ * Packs board values (stored row-wise) into PACKED_TILE_BITS per tile
+ */
+void packBoardValues(const unsigned char values[BOARD_CELLS], unsigned char packed[PACKED_BOARD_BYTES]) {
+#if PACKED_TILE_BITS == 4
+    memset(packed, 0, PACKED_BOARD_BYTES);
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        packed[i / 2] |= values[i] << ((i % 2) * 4);
+    }
+#else
+    memcpy(packed, values, BOARD_CELLS);
+#endif
+}
+
+/**
+ * Undoes packBoardValues
+ */
+void unpackBoardValues(const unsigned char packed[PACKED_BOARD_BYTES], unsigned char values[BOARD_CELLS]) {
+#if PACKED_TILE_BITS == 4
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        values[i] = (packed[i / 2] >> ((i % 2) * 4)) & 0xf;
+    }
+#else
+    memcpy(values, packed, BOARD_CELLS);
+#endif
+}
+
+static uint64_t hashPacked(const unsigned char packed[PACKED_BOARD_BYTES]) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < PACKED_BOARD_BYTES; i++) {
+        hash ^= packed[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static const unsigned char* recordAt(SolutionStore* store, uint64_t record) {
+    return store->data + sizeof(DataHeader) + record * RECORD_BYTES;
+}
+
+static IndexSlot* indexSlots(IndexHeader* index) {
+    return (IndexSlot*)(index + 1);
+}
+
+static size_t indexFileSize(uint64_t slots) {
+    return sizeof(IndexHeader) + slots * sizeof(IndexSlot);
+}
+
+/**
+ * Makes sure at least the given number of bytes of the data file are mapped
+ *
+ * Returns 0 on success, -1 otherwise
+ */
+static int mapData(SolutionStore* store, size_t length) {
+    if (length <= store->dataMapped) {
+        return 0;
+    }
+
+    if (store->data != NULL) {
+        munmap(store->data, store->dataMapped);
+        store->data = NULL;
+    }
+
+    // Read only stores never grow. Writable stores reserve space so appended
+    // records are visible without remapping.
+    size_t mapped = length;
+    if (store->writable) {
+        mapped = length * 2 < MIN_DATA_MAPPING ? MIN_DATA_MAPPING : length * 2;
+    }
+
+    void* data = mmap(NULL, mapped, PROT_READ, MAP_SHARED, store->dataFd, 0);
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        store->dataMapped = 0;
+        return -1;
+    }
+    store->data = data;
+    store->dataMapped = mapped;
+    return 0;
+}
+
+/**
+ * Inserts a record into the index without checking if it is already there
+ */
+static void insertIndex(IndexHeader* index, SolutionStore* store, uint64_t record) {
+    uint64_t hash = hashPacked(recordAt(store, record));
+    uint64_t mask = index->slots - 1;
+    IndexSlot* slots = indexSlots(index);
+
+    uint64_t i = hash & mask;
+    while (slots[i].record != 0) {
+        i = (i + 1) & mask;
+    }
+    slots[i].tag = hash >> 32;
+    slots[i].record = record + 1;
+}
+
+static void unmapIndex(SolutionStore* store) {
+    if (store->index != NULL) {
+        munmap(store->index, store->indexMapped);
+        store->index = NULL;
+    }
+    if (store->indexFd != -1) {
+        close(store->indexFd);
+        store->indexFd = -1;
+    }
+}
+
+/**
+ * Builds a new index with the given number of slots containing every
+ * record in the data file. The new index is written next to the old one
+ * and then moved into its place.
+ *
+ * Returns 0 on success, -1 otherwise
+ */
+static int rebuildIndex(SolutionStore* store, uint64_t slots) {
+    while (slots < MIN_INDEX_SLOTS || slots < 2 * (store->records + 1)) {
+        slots = slots < MIN_INDEX_SLOTS ? MIN_INDEX_SLOTS : slots * 2;
+    }
+
+    size_t pathLength = strlen(store->indexPath);
+    char tempPath[pathLength + 5];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", store->indexPath);
+
+    int fd = open(tempPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        perror(tempPath);
+        return -1;
+    }
+
+    size_t size = indexFileSize(slots);
+    if (ftruncate(fd, size) == -1) {
+        perror("ftruncate");
+        close(fd);
+        return -1;
+    }
+
+    IndexHeader* index = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (index == MAP_FAILED) {
+        perror("mmap");
+        close(fd);
+        return -1;
+    }
+
+    // ftruncate filled the file with zeros so every slot is already empty
+    memcpy(index->magic, INDEX_MAGIC, sizeof(index->magic));
+    index->version = STORE_VERSION;
+    index->boardSize = BOARD_SIZE;
+    index->slots = slots;
+    for (uint64_t record = 0; record < store->records; record++) {
+        insertIndex(index, store, record);
+    }
+    index->records = store->records;
+
+    if (msync(index, size, MS_SYNC) == -1 || rename(tempPath, store->indexPath) == -1) {
+        perror("index");
+        munmap(index, size);
+        close(fd);
+        return -1;
+    }
+
+    unmapIndex(store);
+    store->index = index;
+    store->indexMapped = size;
+    store->indexFd = fd;
+    return 0;
+}
+
+/**
+ * Maps the existing index, repairing or rebuilding it if it does not match
+ * the data file
+ *
+ * Returns 0 on success, -1 otherwise
+ */
+static int openIndex(SolutionStore* store) {
+    store->indexFd = open(store->indexPath, store->writable ? O_RDWR : O_RDONLY);
+
+    struct stat info;
+    if (store->indexFd != -1 && fstat(store->indexFd, &info) == 0
+            && (size_t)info.st_size >= sizeof(IndexHeader)) {
+        int protection = store->writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        IndexHeader* index = mmap(NULL, info.st_size, protection, MAP_SHARED, store->indexFd, 0);
+        if (index != MAP_FAILED) {
+            store->index = index;
+            store->indexMapped = info.st_size;
+        }
+    }
+
+    IndexHeader* index = store->index;
+    bool valid = index != NULL
+        && memcmp(index->magic, INDEX_MAGIC, sizeof(index->magic)) == 0
+        && index->version == STORE_VERSION
+        && index->boardSize == BOARD_SIZE
+        && index->slots >= MIN_INDEX_SLOTS
+        && (index->slots & (index->slots - 1)) == 0
+        && indexFileSize(index->slots) == store->indexMapped
+        && index->records <= store->records;
+
+    if (valid && index->records == store->records) {
+        return 0;
+    }
+
+    if (!store->writable) {
+        fprintf(stderr, "%s: index is out of date, open the store for writing to repair it\n", store->indexPath);
+        return -1;
+    }
+
+    if (valid && 2 * (store->records + 1) <= index->slots) {
+        // Records were appended but never indexed
+        for (uint64_t record = index->records; record < store->records; record++) {
+            insertIndex(index, store, record);
+        }
+        index->records = store->records;
+        return 0;
+    }
+
+    return rebuildIndex(store, valid ? index->slots : MIN_INDEX_SLOTS);
+}
+
+/**
+ * Opens the store at the given path, creating it if it is writable and
+ * does not exist yet
+ *
+ * Returns NULL if the store could not be opened
+ */
+SolutionStore* openSolutionStore(const char* path, bool writable) {
+    SolutionStore* store = calloc(1, sizeof(SolutionStore));
+    if (store == NULL) {
+        return NULL;
+    }
+    store->writable = writable;
+    store->indexFd = -1;
+
+    size_t pathLength = strlen(path);
+    char dataPath[pathLength + 6];
+    snprintf(dataPath, sizeof(dataPath), "%s.data", path);
+    store->indexPath = malloc(pathLength + 7);
+    if (store->indexPath == NULL) {
+        free(store);
+        return NULL;
+    }
+    snprintf(store->indexPath, pathLength + 7, "%s.index", path);
+
+    int flags = writable ? O_RDWR | O_CREAT | O_APPEND : O_RDONLY;
+    store->dataFd = open(dataPath, flags, 0644);
+    if (store->dataFd == -1) {
+        perror(dataPath);
+        closeSolutionStore(store);
+        return NULL;
+    }
+
+    // Held until the store is closed, across repairing or rebuilding the index
+    if (writable && flock(store->dataFd, LOCK_EX | LOCK_NB) == -1) {
+        if (errno == EWOULDBLOCK) {
+            fprintf(stderr, "%s: the store is already open for writing by another process\n", dataPath);
+        }
+        else {
+            perror(dataPath);
+        }
+        closeSolutionStore(store);
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(store->dataFd, &info) == -1) {
+        perror(dataPath);
+        closeSolutionStore(store);
+        return NULL;
+    }
+
+    size_t size = info.st_size;
+    if (size == 0 && writable) {
+        DataHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, DATA_MAGIC, sizeof(header.magic));
+        header.version = STORE_VERSION;
+        header.boardSize = BOARD_SIZE;
+        if (write(store->dataFd, &header, sizeof(header)) != sizeof(header)) {
+            perror(dataPath);
+            closeSolutionStore(store);
+            return NULL;
+        }
+        size = sizeof(header);
+    }
+
+    if (size < sizeof(DataHeader) || mapData(store, size) == -1) {
+        fprintf(stderr, "%s: not a solution store\n", dataPath);
+        closeSolutionStore(store);
+        return NULL;
+    }
+
+    const DataHeader* header = (const DataHeader*)store->data;
+    if (memcmp(header->magic, DATA_MAGIC, sizeof(header->magic)) != 0
+            || header->version != STORE_VERSION || header->boardSize != BOARD_SIZE) {
+        fprintf(stderr, "%s: not a solution store for this board size\n", dataPath);
+        closeSolutionStore(store);
+        return NULL;
+    }
+
+    store->records = (size - sizeof(DataHeader)) / RECORD_BYTES;
+    size_t complete = sizeof(DataHeader) + store->records * RECORD_BYTES;
+    if (complete != size && writable) {
+        // Drop a record that was only partially written
+        if (ftruncate(store->dataFd, complete) == -1) {
+            perror(dataPath);
+            closeSolutionStore(store);
+            return NULL;
+        }
+    }
+
+    if (openIndex(store) == -1) {
+        closeSolutionStore(store);
+        return NULL;
+    }
+
+    return store;
+}
+
+/**
+ * Makes sure everything added to the store so far is on disk
+ *
+ * Returns 0 on success, -1 otherwise
+ */
+int syncSolutionStore(SolutionStore* store) {
+    if (!store->writable) {
+        return 0;
+    }
+
+    if (fsync(store->dataFd) == -1 || msync(store->index, store->indexMapped, MS_SYNC) == -1) {
+        perror("sync");
+        return -1;
+    }
+    return 0;
+}
+
+void closeSolutionStore(SolutionStore* store) {
+    if (store->index != NULL) {
+        syncSolutionStore(store);
+    }
+    unmapIndex(store);
+    if (store->data != NULL) {
+        munmap(store->data, store->dataMapped);
+    }
+    if (store->dataFd != -1) {
+        close(store->dataFd);
+    }
+    free(store->indexPath);
+    free(store);
+}
+
+/**
+ * Finds the packed solution of the given packed board
+ *
+ * Returns a pointer to the solution inside the store (valid until the next
+ * call to addStoredSolution or closeSolutionStore) or NULL if the board has
+ * not been stored
+ */
+const unsigned char* findStoredSolution(SolutionStore* store, const unsigned char packed[PACKED_BOARD_BYTES]) {
+    uint64_t hash = hashPacked(packed);
+    uint32_t tag = hash >> 32;
+    uint64_t mask = store->index->slots - 1;
+    IndexSlot* slots = indexSlots(store->index);
+
+    for (uint64_t i = hash & mask; slots[i].record != 0; i = (i + 1) & mask) {
+        if (slots[i].tag != tag) {
+            continue;
+        }
+
+        const unsigned char* record = recordAt(store, slots[i].record - 1);
+        if (memcmp(record, packed, PACKED_BOARD_BYTES) == 0) {
+            return record + PACKED_BOARD_BYTES;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Appends a board and its solution to the store
+ * Boards that are already in the store are not added again
+ *
+ * Returns 0 on success, -1 otherwise
+ */
+int addStoredSolution(SolutionStore* store, const unsigned char packed[PACKED_BOARD_BYTES],
+        const unsigned char packedSolution[PACKED_BOARD_BYTES]) {
+    if (!store->writable) {
+        return -1;
+    }
+
+    if (findStoredSolution(store, packed) != NULL) {
+        return 0;
+    }
+
+    unsigned char record[RECORD_BYTES];
+    memcpy(record, packed, PACKED_BOARD_BYTES);
+    memcpy(record + PACKED_BOARD_BYTES, packedSolution, PACKED_BOARD_BYTES);
+    if (write(store->dataFd, record, RECORD_BYTES) != RECORD_BYTES) {
+        perror("write");
+        return -1;
+    }
+    store->records++;
+
+    if (mapData(store, sizeof(DataHeader) + store->records * RECORD_BYTES) == -1) {
+        return -1;
+    }
+
+    if (2 * (store->records + 1) > store->index->slots) {
+        return rebuildIndex(store, store->index->slots * 2);
+    }
+
+    insertIndex(store->index, store, store->records - 1);
+    store->index->records = store->records;
+    return 0;
+}
+
+long countStoredSolutions(SolutionStore* store) {
+    return store->records;
+}
+
+/**
+ * Solves the board, answering from the store if possible
+ * Boards that are not in the store are solved with the given engine through
+ * the given cache (if it is not NULL) and added to the store if it is
+ * writable
+ *
+ * Returns 0 if solving was successful, -1 otherwise
+ */
+int solveBoardStored(SolutionStore* store, SolutionCache* cache,
+        const SolverEngine* engine, SudokuBoard* board) {
+    unsigned char values[BOARD_CELLS];
+    unsigned char packed[PACKED_BOARD_BYTES];
+
+    getBoardValues(board, values);
+    packBoardValues(values, packed);
+
+    const unsigned char* stored = findStoredSolution(store, packed);
+    if (stored != NULL) {
+        unpackBoardValues(stored, values);
+        setSolvedBoardValues(board, values);
+        return 0;
+    }
+
+    int result = cache != NULL
+        ? solveBoardCached(cache, engine, board)
+        : engine->solve(board, &defaultSolverOptions, NULL);
+    if (result == -1) {
+        return -1;
+    }
+
+    if (store->writable) {
+        unsigned char packedSolution[PACKED_BOARD_BYTES];
+        getBoardValues(board, values);
+        packBoardValues(values, packedSolution);
+        addStoredSolution(store, packed, packedSolution);
+    }
+
+    return 0;
+}
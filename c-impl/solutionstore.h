@@ -0,0 +1,30 @@
+#ifndef __SOLUTION_STORE_DEFS
+#define __SOLUTION_STORE_DEFS
+
+#include "sudoku.h"
+#include "solutioncache.h"
+
+// Boards are stored with as few bits per tile as their values need
+#if BOARD_SIZE < 16
+#define PACKED_TILE_BITS 4
+#else
+#define PACKED_TILE_BITS 8
+#endif
+#define PACKED_BOARD_BYTES ((BOARD_CELLS * PACKED_TILE_BITS + 7) / 8)
+
+typedef struct SolutionStore SolutionStore;
+
+void packBoardValues(const unsigned char[BOARD_CELLS], unsigned char[PACKED_BOARD_BYTES]);
+void unpackBoardValues(const unsigned char[PACKED_BOARD_BYTES], unsigned char[BOARD_CELLS]);
+
+SolutionStore* openSolutionStore(const char*, bool);
+int syncSolutionStore(SolutionStore*);
+void closeSolutionStore(SolutionStore*);
+
+const unsigned char* findStoredSolution(SolutionStore*, const unsigned char[PACKED_BOARD_BYTES]);
+int addStoredSolution(SolutionStore*, const unsigned char[PACKED_BOARD_BYTES], const unsigned char[PACKED_BOARD_BYTES]);
+long countStoredSolutions(SolutionStore*);
+
+int solveBoardStored(SolutionStore*, SolutionCache*, const SolverEngine*, SudokuBoard*);
+
+#endif
@@ -0,0 +1,512 @@
+/**
+ * A sudoku solving network daemon.
+ *
+ * Listens for TCP connections and solves every board sent on them.
+ * Boards use the same format as solvesudoku: BOARD_SIZE rows of
+ * BOARD_SIZE digits, each row terminated by a newline. Each solved board
+ * (or an error line) is written back on the same connection in the order
+ * the boards were received.
+ *
+ * All connections are multiplexed on a single thread using a non-blocking
+ * epoll event loop. Every connection slot and its buffers are allocated once
+ * at startup so no memory is allocated while serving requests.
+ *
+ * Usage: solvedaemon [-p port] [-c max connections] [-m cached solutions] [-s store]
+ *
+ * Linux only.
+ */
+
+#if __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 600
+#else
+#define _XOPEN_SOURCE 500
+#endif /* __STDC_VERSION__ */
+
+#include <stdio.h>
+#include <stdlib.h> // exit, atoi, atol, calloc, EXIT_FAILURE, EXIT_SUCCESS
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "sudoku.h"
+#include "drawboard.h"
+#include "boardparser.h"
+#include "puzzlesolver.h"
+#include "solverengine.h"
+#include "solutioncache.h"
+#include "solutionstore.h"
+
+#define DEFAULT_PORT 7878
+#define DEFAULT_MAX_CONNECTIONS 4096
+#define LISTEN_BACKLOG 1024
+
+// Number of events handled per call to epoll_wait
+#define MAX_EVENTS 256
+// Maximum number of boards solved together in a single work unit
+#define BATCH_SIZE 64
+
+// Buffer sizes per connection, in boards
+#define INPUT_BOARDS 16
+#define OUTPUT_BOARDS 64
+
+#define INVALID_BOARD_MESSAGE "Invalid board.\n"
+#define NO_SOLUTION_MESSAGE "No solution found.\n"
+
+typedef struct Connection {
+    int fd;
+    // The events this connection is currently registered for in epoll
+    unsigned int events;
+    // The peer will not send any more data
+    bool inputClosed;
+    // The connection has already been queued to be flushed
+    bool touched;
+
+    // Bytes received that have not been parsed yet
+    char input[INPUT_BOARDS * BOARD_TEXT_SIZE];
+    int inputLength;
+
+    // Responses waiting to be written, stored as a ring buffer
+    char output[OUTPUT_BOARDS * BOARD_TEXT_SIZE];
+    int outputStart;
+    int outputLength;
+    // Space in output promised to boards in the current batch
+    int outputReserved;
+
+    // Links unused connection slots together
+    struct Connection* nextFree;
+} Connection;
+
+typedef struct {
+    Connection* connection;
+    SudokuBoard board;
+} WorkItem;
+
+static Connection* connections;
+static Connection* freeConnections;
+
+static WorkItem batch[BATCH_SIZE];
+static int batchLength;
+
+// Connections with new responses that need to be flushed this iteration
+static Connection** touched;
+static int touchedLength;
+
+static int epollFd;
+
+// Optional cache of solved boards, NULL if disabled
+static SolutionCache* cache;
+// Optional persistent store of solved boards, NULL if disabled
+static SolutionStore* store;
+
+/**
+ * Solves the board using whichever of the store and cache are enabled
+ */
+static int solve(SudokuBoard* board) {
+    if (store != NULL) {
+        return solveBoardStored(store, cache, defaultSolverEngine, board);
+    }
+    if (cache != NULL) {
+        return solveBoardCached(cache, defaultSolverEngine, board);
+    }
+    return solveBoard(board);
+}
+
+static void fail(const char* message) {
+    perror(message);
+    exit(EXIT_FAILURE);
+}
+
+static int setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1) {
+        return -1;
+    }
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/**
+ * Registers the connection for exactly the events it is able to handle.
+ * Input is only requested while there is room to receive it and output
+ * only while there is something left to write.
+ */
+static void updateEvents(Connection* conn) {
+    unsigned int events = 0;
+    if (!conn->inputClosed && conn->inputLength < (int)sizeof(conn->input)) {
+        events |= EPOLLIN;
+    }
+    // Boards that did not fit into the output are picked up again as soon as
+    // the socket is writable
+    if (conn->outputLength > 0 || conn->inputLength >= BOARD_TEXT_SIZE) {
+        events |= EPOLLOUT;
+    }
+
+    if (events == conn->events) {
+        return;
+    }
+
+    struct epoll_event event;
+    event.events = events;
+    event.data.ptr = conn;
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, conn->fd, &event) == -1) {
+        fail("epoll_ctl");
+    }
+    conn->events = events;
+}
+
+static void closeConnection(Connection* conn) {
+    close(conn->fd);
+    conn->fd = -1;
+    conn->nextFree = freeConnections;
+    freeConnections = conn;
+}
+
+static void acceptConnections(int listenFd) {
+    while (true) {
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("accept");
+            }
+            return;
+        }
+
+        Connection* conn = freeConnections;
+        if (conn == NULL || setNonBlocking(fd) == -1) {
+            // No free slots, turn the client away
+            close(fd);
+            continue;
+        }
+        freeConnections = conn->nextFree;
+
+        conn->fd = fd;
+        conn->events = EPOLLIN;
+        conn->inputClosed = false;
+        conn->touched = false;
+        conn->inputLength = 0;
+        conn->outputStart = 0;
+        conn->outputLength = 0;
+        conn->outputReserved = 0;
+
+        struct epoll_event event;
+        event.events = conn->events;
+        event.data.ptr = conn;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            perror("epoll_ctl");
+            closeConnection(conn);
+        }
+    }
+}
+
+/**
+ * Appends a response to the connection's output ring buffer
+ * Space for it must have been reserved beforehand
+ */
+static void appendOutput(Connection* conn, const char* data, int length) {
+    int capacity = sizeof(conn->output);
+    for (int i = 0; i < length; i++) {
+        conn->output[(conn->outputStart + conn->outputLength + i) % capacity] = data[i];
+    }
+    conn->outputLength += length;
+}
+
+/**
+ * Solves every board in the current batch and queues the responses
+ */
+static void runBatch(void) {
+    char response[BOARD_TEXT_SIZE];
+
+    for (int i = 0; i < batchLength; i++) {
+        WorkItem* item = &batch[i];
+        Connection* conn = item->connection;
+
+        if (!isValidBoard(&item->board)) {
+            appendOutput(conn, INVALID_BOARD_MESSAGE, sizeof(INVALID_BOARD_MESSAGE) - 1);
+        }
+        else if (solve(&item->board) == -1) {
+            appendOutput(conn, NO_SOLUTION_MESSAGE, sizeof(NO_SOLUTION_MESSAGE) - 1);
+        }
+        else {
+            int length = formatSudokuBoardSimple(&item->board, response);
+            appendOutput(conn, response, length);
+        }
+        conn->outputReserved -= BOARD_TEXT_SIZE;
+    }
+    batchLength = 0;
+}
+
+/**
+ * Moves every complete board in the connection's input into the batch,
+ * as long as there is room to write its response
+ *
+ * If the input cannot be parsed, the rest of it is discarded and the
+ * connection is closed once the responses queued so far have been written
+ */
+static void extractBoards(Connection* conn) {
+    int offset = 0;
+    int outputCapacity = sizeof(conn->output);
+
+    while (conn->inputLength - offset >= BOARD_TEXT_SIZE) {
+        if (conn->outputLength + conn->outputReserved + BOARD_TEXT_SIZE > outputCapacity) {
+            // Wait for the client to read its responses
+            break;
+        }
+
+        if (batchLength == BATCH_SIZE) {
+            runBatch();
+        }
+
+        WorkItem* item = &batch[batchLength];
+        if (parseBoard(conn->input + offset, &item->board) == -1) {
+            conn->inputClosed = true;
+            offset = conn->inputLength;
+            break;
+        }
+        item->connection = conn;
+        batchLength++;
+
+        conn->outputReserved += BOARD_TEXT_SIZE;
+        offset += BOARD_TEXT_SIZE;
+    }
+
+    if (offset > 0) {
+        memmove(conn->input, conn->input + offset, conn->inputLength - offset);
+        conn->inputLength -= offset;
+    }
+
+    if (!conn->touched) {
+        conn->touched = true;
+        touched[touchedLength++] = conn;
+    }
+}
+
+/**
+ * Reads as much as will fit into the connection's input buffer
+ *
+ * Returns 0 on success, -1 if the connection failed
+ */
+static int readConnection(Connection* conn) {
+    int space = sizeof(conn->input) - conn->inputLength;
+    if (space == 0 || conn->inputClosed) {
+        return 0;
+    }
+
+    ssize_t received = read(conn->fd, conn->input + conn->inputLength, space);
+    if (received == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        return -1;
+    }
+
+    if (received == 0) {
+        conn->inputClosed = true;
+    }
+    conn->inputLength += received;
+    return 0;
+}
+
+/**
+ * Writes as much of the pending output as the socket will accept using
+ * a single writev call covering both halves of the ring buffer
+ *
+ * Returns 0 on success, -1 if the connection failed
+ */
+static int flushConnection(Connection* conn) {
+    if (conn->outputLength == 0) {
+        return 0;
+    }
+
+    int capacity = sizeof(conn->output);
+    int firstLength = capacity - conn->outputStart;
+    if (firstLength > conn->outputLength) {
+        firstLength = conn->outputLength;
+    }
+
+    struct iovec chunks[2];
+    chunks[0].iov_base = conn->output + conn->outputStart;
+    chunks[0].iov_len = firstLength;
+    chunks[1].iov_base = conn->output;
+    chunks[1].iov_len = conn->outputLength - firstLength;
+
+    ssize_t written = writev(conn->fd, chunks, chunks[1].iov_len > 0 ? 2 : 1);
+    if (written == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        return -1;
+    }
+
+    conn->outputStart = (conn->outputStart + written) % capacity;
+    conn->outputLength -= written;
+    return 0;
+}
+
+/**
+ * Flushes responses for every connection touched this iteration and
+ * closes connections that are finished
+ */
+static void finishIteration(void) {
+    for (int i = 0; i < touchedLength; i++) {
+        Connection* conn = touched[i];
+        conn->touched = false;
+
+        if (flushConnection(conn) == -1) {
+            closeConnection(conn);
+            continue;
+        }
+
+        bool finished = conn->inputClosed && conn->outputLength == 0
+            && conn->inputLength < BOARD_TEXT_SIZE;
+        if (finished) {
+            closeConnection(conn);
+            continue;
+        }
+
+        updateEvents(conn);
+    }
+    touchedLength = 0;
+}
+
+static int listenOn(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        fail("socket");
+    }
+
+    int reuse = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == -1) {
+        fail("setsockopt");
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) == -1) {
+        fail("bind");
+    }
+    if (listen(fd, LISTEN_BACKLOG) == -1) {
+        fail("listen");
+    }
+    if (setNonBlocking(fd) == -1) {
+        fail("fcntl");
+    }
+    return fd;
+}
+
+int main(int argc, char* argv[]) {
+    int port = DEFAULT_PORT;
+    int maxConnections = DEFAULT_MAX_CONNECTIONS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            maxConnections = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            cache = createSolutionCache(atol(argv[++i]));
+            if (cache == NULL) {
+                fail("createSolutionCache");
+            }
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            store = openSolutionStore(argv[++i], true);
+            if (store == NULL) {
+                return EXIT_FAILURE;
+            }
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-p port] [-c max connections] [-m cached solutions] [-s store]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (maxConnections < 1) {
+        fprintf(stderr, "Invalid number of connections\n");
+        return EXIT_FAILURE;
+    }
+
+    // Clients that disconnect early should not kill the daemon
+    signal(SIGPIPE, SIG_IGN);
+
+    connections = calloc(maxConnections, sizeof(Connection));
+    touched = calloc(maxConnections, sizeof(Connection*));
+    if (connections == NULL || touched == NULL) {
+        fail("calloc");
+    }
+    freeConnections = NULL;
+    for (int i = maxConnections - 1; i >= 0; i--) {
+        connections[i].fd = -1;
+        connections[i].nextFree = freeConnections;
+        freeConnections = &connections[i];
+    }
+
+    int listenFd = listenOn(port);
+
+    epollFd = epoll_create(MAX_EVENTS);
+    if (epollFd == -1) {
+        fail("epoll_create");
+    }
+
+    // The listening socket is the only registration without a connection
+    struct epoll_event listenEvent;
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.ptr = NULL;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &listenEvent) == -1) {
+        fail("epoll_ctl");
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (true) {
+        int ready = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fail("epoll_wait");
+        }
+
+        for (int i = 0; i < ready; i++) {
+            Connection* conn = events[i].data.ptr;
+            if (conn == NULL) {
+                acceptConnections(listenFd);
+                continue;
+            }
+
+            if (conn->fd == -1 || conn->touched) {
+                // Already closed or handled during this iteration
+                continue;
+            }
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                // Keep any data that was already received before the hang up
+                if (readConnection(conn) == -1) {
+                    closeConnection(conn);
+                    continue;
+                }
+                conn->inputClosed = true;
+            }
+            else if (readConnection(conn) == -1) {
+                closeConnection(conn);
+                continue;
+            }
+
+            extractBoards(conn);
+        }
+
+        runBatch();
+        finishIteration();
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,117 @@
+/**
+ * The solver engines that programs can choose from
+ *
+ * Every engine solves the same boards. They only differ in how they
+ * represent the board while searching, so they can be compared with each
+ * other on the same puzzles.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+#include "solverengine.h"
+#include "portfoliosolver.h"
+// The other engines only know the rules of classic sudoku (see variants.c)
+#ifndef VARIANTS
+#include "satsolver.h"
+#if BOARD_SIZE == 9
+#include "bitboardsolver.h"
+#include "templatesolver.h"
+#ifdef HAVE_RUST_SOLVER
+#include "rustsolver.h"
+#endif
+#endif
+
+// The number of guesses the escalating engine lets the classic solver make
+// unless options->guessBudget says otherwise
+#define ESCALATION_GUESS_BUDGET 100
+
+/**
+ * Solves the board with the classic solver, but hands it to the SAT engine
+ * if the classic solver runs out of guesses. That bounds how long the
+ * classic solver can spend on boards that defeat its heuristics.
+ * stats (if not NULL) adds up the statistics of both.
+ *
+ * Returns 0 if solving was successful, -1 otherwise
+ */
+static int solveBoardEscalating(SudokuBoard* board, const SolverOptions* options, SolverStats* stats) {
+    SolverStats localStats;
+    if (stats == NULL) {
+        stats = &localStats;
+    }
+
+    SolverOptions budgeted = *options;
+    if (budgeted.guessBudget == 0) {
+        budgeted.guessBudget = ESCALATION_GUESS_BUDGET;
+    }
+
+    SudokuBoard copy;
+    copySudokuBoard(board, &copy);
+    if (solveBoardWithOptions(&copy, &budgeted, stats) == 0) {
+        copySudokuBoard(&copy, board);
+        return 0;
+    }
+    // Failing before the budget ran out means there is no solution
+    if (!stats->budgetExhausted) {
+        return -1;
+    }
+
+    SolverStats satStats;
+    int result = solveBoardSat(board, options, &satStats);
+    stats->guesses += satStats.guesses;
+    stats->conflicts += satStats.conflicts;
+    // The SAT engine has no budget, so the search as a whole did not give up
+    stats->budgetExhausted = false;
+    return result;
+}
+#endif
+
+static const SolverEngine engines[] = {
+#if defined(HAVE_RUST_SOLVER) && !defined(VARIANTS) && BOARD_SIZE == 9
+    // The solver of the Rust crate (see rustsolver.c), which is the default
+    // when it is linked in
+    {"rust", solveBoardRust},
+#endif
+    // The tile based solver in puzzlesolver.c
+    {"classic", solveBoardWithOptions},
+    // Races several configurations of the classic solver
+    {"portfolio", solveBoardPortfolio},
+#ifndef VARIANTS
+    // Conflict driven clause learning on a CNF encoding of the board
+    {"sat", solveBoardSat},
+    // The classic solver with the SAT engine once it makes too many guesses
+    {"escalating", solveBoardEscalating},
+#if BOARD_SIZE == 9
+    {"bitboard", solveBoardBitboard},
+    // Combines precomputed placements of whole digits
+    {"templates", solveBoardTemplates},
+#endif
+#endif
+};
+
+#define ENGINE_COUNT ((int)(sizeof(engines) / sizeof(engines[0])))
+
+const SolverEngine* const defaultSolverEngine = &engines[0];
+
+/**
+ * Returns the engine with the given name or NULL if there is no such engine
+ * for this board size
+ */
+const SolverEngine* findSolverEngine(const char* name) {
+    for (int i = 0; i < ENGINE_COUNT; i++) {
+        if (strcmp(engines[i].name, name) == 0) {
+            return &engines[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Writes the names of every engine separated by '|' (for usage messages)
+ */
+void printSolverEngineNames(FILE* file) {
+    for (int i = 0; i < ENGINE_COUNT; i++) {
+        fprintf(file, i == 0 ? "%s" : "|%s", engines[i].name);
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef __SOLVER_ENGINE_DEFS
+#define __SOLVER_ENGINE_DEFS
+
+#include <stdio.h>
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+
+typedef struct {
+    // The name used to pick the engine on the command line
+    const char* name;
+    // Solves the board in place, returns 0 if successful, -1 otherwise
+    int (*solve)(SudokuBoard*, const SolverOptions*, SolverStats*);
+} SolverEngine;
+
+extern const SolverEngine* const defaultSolverEngine;
+
+const SolverEngine* findSolverEngine(const char*);
+void printSolverEngineNames(FILE*);
+
+#endif
@@ -5,35 +5,292 @@
  * Rows should be BOARD_SIZE
  * Solves as many boards as provided on stdin until EOF
  * Use 0 to mark an empty tile
+ * Boards can also be written on a single line with . or 0 for empty tiles
+ * (see boardreader.c), except in variant builds
+ * gzip (and zstd) compressed input is decompressed as it is read, except in
+ * variant builds. With --compress, the output is compressed as well.
+ *
+ * With --verify, the boards are checked instead of solved: every board is
+ * answered with "Solved." (filled without conflicts), "Valid." (no conflicts
+ * so far) or "Invalid board.". Boards are read in either format, like when
+ * solving them, and text that is not a board is answered with "Invalid
+ * board." and ends the check. With --givens, every board must also keep the
+ * values of the board at the same position in that file, which may be
+ * compressed as well.
  */
 
 #include <stdio.h>
+#include <stdlib.h> // atol, EXIT_FAILURE, EXIT_SUCCESS
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h> // close, STDIN_FILENO
 
 #include "sudoku.h"
 #include "drawboard.h"
 #include "boardparser.h"
+#include "boardreader.h"
+#include "compressedstream.h"
 #include "puzzlesolver.h"
+#include "solverengine.h"
+#include "solutioncache.h"
+#include "solutionstore.h"
+#include "verifier.h"
+
+static void printUsage(char* program) {
+    fprintf(stderr, "Usage: %s [--cache entries] [--store path] [--engine ", program);
+    printSolverEngineNames(stderr);
+    fprintf(stderr, "] [--compress gzip|zstd]\n");
+#ifndef VARIANTS
+    fprintf(stderr, "       %s --verify [--givens path] [--compress gzip|zstd]\n", program);
+#endif
+}
+
+#ifndef VARIANTS
+/**
+ * Reads up to VERIFY_LANES boards from reader into the lanes of batch and
+ * empties the lanes after them
+ *
+ * Returns the number of boards read
+ */
+static int readBoardLanes(BoardReader* reader, GridBatch* batch) {
+    unsigned char values[BOARD_CELLS];
+    int lanes = 0;
+    while (lanes < VERIFY_LANES && readBoardValues(reader, values) == 0) {
+        setGridLane(batch, lanes++, values);
+    }
+    for (int lane = lanes; lane < VERIFY_LANES; lane++) {
+        clearGridLane(batch, lane);
+    }
+    return lanes;
+}
+
+/**
+ * Checks every board of reader (against the board at the same position in
+ * givensReader if it is not NULL) and prints the result for each of them
+ */
+static void verifyBoards(BoardReader* reader, BoardReader* givensReader) {
+    static const char* answers[] = {
+        [GRID_INVALID] = "Invalid board.\n",
+        [GRID_VALID] = "Valid.\n",
+        [GRID_SOLVED] = "Solved.\n",
+    };
+    long counts[3] = {0};
+
+    GridBatch grids;
+    GridBatch givens;
+    // Every answer of a batch is written at once
+    char output[VERIFY_LANES * sizeof("Invalid board.\n")];
+
+    int lanes;
+    while ((lanes = readBoardLanes(reader, &grids)) > 0) {
+        // Boards without givens cannot be checked against them
+        int givenLanes = givensReader != NULL ? readBoardLanes(givensReader, &givens) : lanes;
+
+        GridStatus statuses[VERIFY_LANES];
+        verifyGridBatch(&grids, givensReader != NULL ? &givens : NULL, statuses);
+
+        size_t length = 0;
+        for (int lane = 0; lane < lanes; lane++) {
+            GridStatus status = lane < givenLanes ? statuses[lane] : GRID_INVALID;
+            counts[status]++;
+            size_t answerLength = strlen(answers[status]);
+            memcpy(output + length, answers[status], answerLength);
+            length += answerLength;
+        }
+        fwrite(output, 1, length, stdout);
+    }
+
+    // The boards after one that could not be read cannot be told apart
+    if (!boardReaderAtEnd(reader)) {
+        counts[GRID_INVALID]++;
+        fputs(answers[GRID_INVALID], stdout);
+    }
+
+    fprintf(stderr, "%ld solved, %ld valid, %ld invalid\n",
+        counts[GRID_SOLVED], counts[GRID_VALID], counts[GRID_INVALID]);
+}
+#endif
 
 int main(int argc, char* argv[]) {
     SudokuBoard board;
+    SolutionCache* cache = NULL;
+    SolutionStore* store = NULL;
+    const SolverEngine* engine = defaultSolverEngine;
+    bool verify = false;
+    const char* givensPath = NULL;
+    Compression outputCompression = COMPRESSION_NONE;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache = createSolutionCache(atol(argv[++i]));
+            if (cache == NULL) {
+                fprintf(stderr, "Unable to allocate the solution cache\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--store") == 0 && i + 1 < argc) {
+            store = openSolutionStore(argv[++i], true);
+            if (store == NULL) {
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            engine = findSolverEngine(argv[++i]);
+            if (engine == NULL) {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--compress") == 0 && i + 1 < argc) {
+            if (parseCompression(argv[++i], &outputCompression) == -1) {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+#ifndef VARIANTS
+        else if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+        }
+        else if (strcmp(argv[i], "--givens") == 0 && i + 1 < argc) {
+            givensPath = argv[++i];
+        }
+#endif
+        else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (givensPath != NULL && !verify) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    OutputStream* output = NULL;
+    if (outputCompression != COMPRESSION_NONE && (output = startCompressedOutput(outputCompression)) == NULL) {
+        return EXIT_FAILURE;
+    }
+#ifndef VARIANTS
+    if (verify) {
+        int givensFd = -1;
+        InputStream* givensInput = NULL;
+        BoardReader* givensReader = NULL;
+        if (givensPath != NULL) {
+            if ((givensFd = open(givensPath, O_RDONLY)) == -1) {
+                perror(givensPath);
+                return EXIT_FAILURE;
+            }
+            if ((givensInput = openInputStream(givensFd)) == NULL) {
+                return EXIT_FAILURE;
+            }
+            if ((givensReader = createBoardReaderFrom(readInputStream, givensInput)) == NULL) {
+                fprintf(stderr, "Unable to allocate the input buffer\n");
+                return EXIT_FAILURE;
+            }
+        }
+        InputStream* input = openInputStream(STDIN_FILENO);
+        if (input == NULL) {
+            return EXIT_FAILURE;
+        }
+        BoardReader* reader = createBoardReaderFrom(readInputStream, input);
+        if (reader == NULL) {
+            fprintf(stderr, "Unable to allocate the input buffer\n");
+            return EXIT_FAILURE;
+        }
+
+        verifyBoards(reader, givensReader);
+        int status = EXIT_SUCCESS;
+        freeBoardReader(reader);
+        if (closeInputStream(input) == -1) {
+            status = EXIT_FAILURE;
+        }
+        if (givensInput != NULL) {
+            freeBoardReader(givensReader);
+            if (closeInputStream(givensInput) == -1) {
+                status = EXIT_FAILURE;
+            }
+            close(givensFd);
+        }
+        if (output != NULL && finishCompressedOutput(output) == -1) {
+            status = EXIT_FAILURE;
+        }
+        return status;
+    }
+
+    InputStream* input = openInputStream(STDIN_FILENO);
+    if (input == NULL) {
+        return EXIT_FAILURE;
+    }
+    BoardReader* reader = createBoardReaderFrom(readInputStream, input);
+    if (reader == NULL) {
+        fprintf(stderr, "Unable to allocate the input buffer\n");
+        return EXIT_FAILURE;
+    }
+#endif
 
     while (true) {
+#ifdef VARIANTS
+        // Boards are read with the rule lines in front of them
         if (readBoard(stdin, &board) == -1) {
             break;
         }
+#else
+        if (readNextBoard(reader, &board) == -1) {
+            break;
+        }
+#endif
 
         if (!isValidBoard(&board)) {
             printf("Invalid board.\n");
             continue;
         }
 
-        if (solveBoard(&board) == -1) {
+#ifdef VARIANTS
+        // Stored solutions only go by the values of a board, not its rules
+        bool cacheable = board.rules == NULL;
+#else
+        bool cacheable = true;
+#endif
+
+        int result;
+        if (store != NULL && cacheable) {
+            result = solveBoardStored(store, cache, engine, &board);
+        }
+        else if (cache != NULL && cacheable) {
+            result = solveBoardCached(cache, engine, &board);
+        }
+        else {
+            result = engine->solve(&board, &defaultSolverOptions, NULL);
+        }
+        if (result == -1) {
             printf("No solution found.\n");
             continue;
         }
 
         drawSudokuBoardSimple(&board);
     }
+    int status = EXIT_SUCCESS;
+#ifndef VARIANTS
+    freeBoardReader(reader);
+    if (closeInputStream(input) == -1) {
+        status = EXIT_FAILURE;
+    }
+#endif
+
+    if (cache != NULL) {
+        SolutionCacheStats stats;
+        getSolutionCacheStats(cache, &stats);
+        fprintf(stderr, "Solution cache: %ld hits, %ld misses\n", stats.hits, stats.misses);
+        freeSolutionCache(cache);
+    }
+
+    if (store != NULL) {
+        closeSolutionStore(store);
+    }
+
+    if (output != NULL && finishCompressedOutput(output) == -1) {
+        status = EXIT_FAILURE;
+    }
 
-    return 0;
+    return status;
 }
@@ -6,6 +6,9 @@
 #include <stdbool.h>
 
 #include "sudoku.h"
+#ifdef VARIANTS
+#include "variants.h"
+#endif
 
 /**
  * Converts tile column/row indexes to the appropriate index in the
@@ -15,6 +18,14 @@ static int coordinatesToTileIndex(int row_i, int col_i) {
     return row_i * BOARD_SIZE + col_i;
 }
 
+static inline void addToTileSet(TileSet* set, int index) {
+    set->words[index / 64] |= (uint64_t)1 << (index % 64);
+}
+
+static inline void removeFromTileSet(TileSet* set, int index) {
+    set->words[index / 64] &= ~((uint64_t)1 << (index % 64));
+}
+
 /**
  * Initializes a sudoku board to be a completely empty (all zeros) board
  * Does not allocate any memory
@@ -25,14 +36,34 @@ void emptySudokuBoard(SudokuBoard* board) {
     for (int i = 0; i < BOARD_SIZE; i++) {
         for (int j = 0; j < BOARD_SIZE; j++) {
             index = coordinatesToTileIndex(i, j);
+            board->tiles[index].value = 0;
             // There are BOARD_SIZE possible values for every tile on
             // an empty board
-            for (int p = 0; p < BOARD_SIZE; p++) {
-                board->tiles[index].possibleValues[p] = true;
-            }
+            board->tiles[index].possibleValues = ALL_CANDIDATES;
             board->tiles[index].possibleCount = BOARD_SIZE;
         }
+
+        board->rowValues[i] = 0;
+        board->colValues[i] = 0;
+        board->boxValues[i] = 0;
+    }
+
+    // Every tile starts out with every possible value
+    for (int count = 0; count <= BOARD_SIZE; count++) {
+        for (int i = 0; i < TILE_SET_WORDS; i++) {
+            board->tilesByCount[count].words[i] = 0;
+        }
     }
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        addToTileSet(&board->tilesByCount[BOARD_SIZE], i);
+    }
+
+    board->emptyCount = BOARD_CELLS;
+    board->hasConflict = false;
+    board->hasDeadEnd = false;
+#ifdef VARIANTS
+    board->rules = NULL;
+#endif
 }
 
 /**
@@ -44,59 +75,229 @@ void copySudokuBoard(SudokuBoard* board, SudokuBoard* copy) {
     *copy = *board;
 }
 
+/**
+ * Removes value (as valueBit) from the possible values of the tile at index
+ * Moves empty tiles to their new count in tilesByCount and marks the board
+ * as a dead end if that leaves an empty tile without any possible values
+ *
+ * Returns whether the value was possible before
+ */
+static inline bool removePossibleValue(SudokuBoard* board, int index, CandidateMask valueBit) {
+    Tile* tile = &(board->tiles[index]);
+    if (!(tile->possibleValues & valueBit)) {
+        return false;
+    }
+
+    // Tile was available, now it is not
+    tile->possibleValues &= ~valueBit;
+    tile->possibleCount--;
+
+    if (tile->value == 0) {
+        removeFromTileSet(&board->tilesByCount[tile->possibleCount + 1], index);
+        addToTileSet(&board->tilesByCount[tile->possibleCount], index);
+        if (tile->possibleCount == 0) {
+            board->hasDeadEnd = true;
+        }
+    }
+    return true;
+}
+
 /**
  * Places a value on the sudoku board. Updates all related possible value
- * caches and their counts.
+ * caches and their counts as well as the board's empty count, the values of
+ * its rows, columns and boxes, its conflict and dead end flags and the index
+ * of empty tiles by their number of possible values.
+ *
+ * Values must only be placed on empty tiles
  */
 void placeSudokuValue(SudokuBoard* board, int row_i, int col_i, short value) {
-    // Place the value on its tile
-    int index = coordinatesToTileIndex(row_i, col_i);
-    board->tiles[index].value = value;
-
     if (value == 0) {
         return;
     }
 
+    // Place the value on its tile
+    int index = coordinatesToTileIndex(row_i, col_i);
+    removeFromTileSet(&board->tilesByCount[board->tiles[index].possibleCount], index);
+    board->tiles[index].value = value;
+    board->emptyCount--;
+
     // The start index of this tile's box
     int boxRowStart = (row_i / BOX_SIZE) * BOX_SIZE;
     int boxColStart = (col_i / BOX_SIZE) * BOX_SIZE;
+    int box_i = (row_i / BOX_SIZE) * BOX_SIZE + col_i / BOX_SIZE;
 
-    // The index at which this value will be found in all possibleValue arrays
-    int valueIndex = value - 1;
+    // The bit that represents this value in all possibleValues sets
+    CandidateMask valueBit = CANDIDATE_BIT(value);
+
+    CandidateMask unitValues = board->rowValues[row_i] | board->colValues[col_i]
+        | board->boxValues[box_i];
+    if (unitValues & valueBit) {
+        board->hasConflict = true;
+    }
+    board->rowValues[row_i] |= valueBit;
+    board->colValues[col_i] |= valueBit;
+    board->boxValues[box_i] |= valueBit;
 
     for (int i = 0; i < BOARD_SIZE; i++) {
         // Update items in the same row
-        index = coordinatesToTileIndex(row_i, i);
-        Tile* rowItem = &(board->tiles[index]);
-        if (rowItem->possibleValues[valueIndex]) {
-            // Tile was available, now it is not
-            rowItem->possibleValues[valueIndex] = false;
-            rowItem->possibleCount--;
-        }
+        removePossibleValue(board, coordinatesToTileIndex(row_i, i), valueBit);
 
         // Update items in the same column
-        index = coordinatesToTileIndex(i, col_i);
-        Tile* colItem = &(board->tiles[index]);
-        if (colItem->possibleValues[valueIndex]) {
-            // Tile was available, now it is not
-            colItem->possibleValues[valueIndex] = false;
-            colItem->possibleCount--;
-        }
+        removePossibleValue(board, coordinatesToTileIndex(i, col_i), valueBit);
 
         // Update items in the same box
         index = coordinatesToTileIndex(boxRowStart + i / BOX_SIZE,
                     boxColStart + i % BOX_SIZE);
-        Tile* boxItem = &(board->tiles[index]);
-        if (boxItem->possibleValues[valueIndex]) {
-            // Tile was available, now it is not
-            boxItem->possibleValues[valueIndex] = false;
-            boxItem->possibleCount--;
+        removePossibleValue(board, index, valueBit);
+    }
+
+#ifdef VARIANTS
+    if (board->rules != NULL) {
+        placeVariantValue(board, coordinatesToTileIndex(row_i, col_i), value);
+    }
+#endif
+}
+
+/**
+ * Rules out a value for an empty tile without placing anything. Updates the
+ * tile's possible values and count, the index of empty tiles and the dead
+ * end flag like placeSudokuValue does for the tiles it affects.
+ *
+ * Returns whether the value was possible before
+ */
+bool eliminateSudokuValue(SudokuBoard* board, int row_i, int col_i, short value) {
+    return removePossibleValue(board, coordinatesToTileIndex(row_i, col_i), CANDIDATE_BIT(value));
+}
+
+/**
+ * Adds value (as valueBit) back to the possible values of the tile at index
+ * if it is empty, moving it to its new count in tilesByCount
+ */
+static inline void restorePossibleValue(SudokuBoard* board, int index, CandidateMask valueBit) {
+    Tile* tile = &(board->tiles[index]);
+    if (tile->value != 0 || (tile->possibleValues & valueBit)) {
+        return;
+    }
+
+    removeFromTileSet(&board->tilesByCount[tile->possibleCount], index);
+    tile->possibleValues |= valueBit;
+    tile->possibleCount++;
+    addToTileSet(&board->tilesByCount[tile->possibleCount], index);
+}
+
+/**
+ * Returns the values placed in the given unit (one of the rows, columns or
+ * boxes), and sets the conflict flag if any of them is placed twice
+ */
+static CandidateMask findUnitValues(SudokuBoard* board, int unit) {
+    CandidateMask values = 0;
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        short value = board->tiles[unitTile(unit, i)].value;
+        if (value == 0) {
+            continue;
+        }
+        if (values & CANDIDATE_BIT(value)) {
+            board->hasConflict = true;
+        }
+        values |= CANDIDATE_BIT(value);
+    }
+    return values;
+}
+
+/**
+ * Removes the value from the tile at the given position, the opposite of
+ * placeSudokuValue. The erased value becomes possible again on the tile and
+ * on every tile of its row, column and box that has no other tile with the
+ * value in its own row, column or box. The erased tile gets every value that
+ * is not in its row, column or box.
+ *
+ * Values ruled out with eliminateSudokuValue are only restored on the tiles
+ * mentioned above, so this is meant for boards where values were only ruled
+ * out by placing them. Does nothing if the tile is empty.
+ */
+void eraseSudokuValue(SudokuBoard* board, int row_i, int col_i) {
+    int index = coordinatesToTileIndex(row_i, col_i);
+    short value = board->tiles[index].value;
+    if (value == 0) {
+        return;
+    }
+
+#ifdef VARIANTS
+    if (board->rules != NULL) {
+        // Extra peers and cages are simplest to repair by starting over
+        const struct VariantRules* rules = board->rules;
+        unsigned char values[BOARD_CELLS];
+        getBoardValues(board, values);
+        values[index] = 0;
+        emptySudokuBoard(board);
+        applyVariantRules(board, rules);
+        for (int i = 0; i < BOARD_CELLS; i++) {
+            placeSudokuValue(board, i / BOARD_SIZE, i % BOARD_SIZE, values[i]);
+        }
+        return;
+    }
+#endif
+
+    board->tiles[index].value = 0;
+    board->emptyCount++;
+
+    int boxRowStart = (row_i / BOX_SIZE) * BOX_SIZE;
+    int boxColStart = (col_i / BOX_SIZE) * BOX_SIZE;
+    int box_i = (row_i / BOX_SIZE) * BOX_SIZE + col_i / BOX_SIZE;
+
+    // The value may still be in these units if it was placed twice, and
+    // the conflict may be gone
+    bool hadConflict = board->hasConflict;
+    board->hasConflict = false;
+    if (hadConflict) {
+        for (int unit = 0; unit < 3 * BOARD_SIZE; unit++) {
+            findUnitValues(board, unit);
+        }
+    }
+    board->rowValues[row_i] = findUnitValues(board, row_i);
+    board->colValues[col_i] = findUnitValues(board, BOARD_SIZE + col_i);
+    board->boxValues[box_i] = findUnitValues(board, 2 * BOARD_SIZE + box_i);
+
+    Tile* tile = &(board->tiles[index]);
+    tile->possibleValues = ALL_CANDIDATES
+        & ~(board->rowValues[row_i] | board->colValues[col_i] | board->boxValues[box_i]);
+    tile->possibleCount = countCandidates(tile->possibleValues);
+    addToTileSet(&board->tilesByCount[tile->possibleCount], index);
+
+    CandidateMask valueBit = CANDIDATE_BIT(value);
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        int peerRow, peerCol;
+
+        // Items in the same row
+        peerCol = i;
+        if (!((board->colValues[peerCol] | board->rowValues[row_i]
+                | board->boxValues[(row_i / BOX_SIZE) * BOX_SIZE + peerCol / BOX_SIZE]) & valueBit)) {
+            restorePossibleValue(board, coordinatesToTileIndex(row_i, peerCol), valueBit);
+        }
+
+        // Items in the same column
+        peerRow = i;
+        if (!((board->rowValues[peerRow] | board->colValues[col_i]
+                | board->boxValues[(peerRow / BOX_SIZE) * BOX_SIZE + col_i / BOX_SIZE]) & valueBit)) {
+            restorePossibleValue(board, coordinatesToTileIndex(peerRow, col_i), valueBit);
+        }
+
+        // Items in the same box
+        peerRow = boxRowStart + i / BOX_SIZE;
+        peerCol = boxColStart + i % BOX_SIZE;
+        if (!((board->rowValues[peerRow] | board->colValues[peerCol] | board->boxValues[box_i]) & valueBit)) {
+            restorePossibleValue(board, coordinatesToTileIndex(peerRow, peerCol), valueBit);
         }
     }
+
+    // The tiles left without any possible values are still indexed
+    board->hasDeadEnd = firstTileInSet(&board->tilesByCount[0]) != -1;
 }
 
 /**
  * Sets all items in a single board row to items
+ * Tiles are copied as they are, so the board's empty count, unit values,
+ * flags and tile index are not updated
  */
 void setBoardRow(SudokuBoard* board, int row_i, Tile items[BOARD_SIZE]) {
     int index;
@@ -116,6 +317,54 @@ void setBoardRowValues(SudokuBoard* board, int row_i, short items[BOARD_SIZE]) {
     }
 }
 
+/**
+ * Copies the value of every tile into values, stored row-wise
+ * 0 marks an empty tile
+ */
+void getBoardValues(SudokuBoard* board, unsigned char values[BOARD_CELLS]) {
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        values[i] = board->tiles[i].value;
+    }
+}
+
+/**
+ * Resets the board and places every value in values (stored row-wise)
+ * 0 marks an empty tile
+ */
+void setBoardValues(SudokuBoard* board, const unsigned char values[BOARD_CELLS]) {
+    emptySudokuBoard(board);
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        placeSudokuValue(board, i / BOARD_SIZE, i % BOARD_SIZE, values[i]);
+    }
+}
+
+/**
+ * Overwrites every tile with the values of a complete, valid board
+ * Possible value caches are left as they are since they are not used once
+ * every tile is filled
+ */
+void setSolvedBoardValues(SudokuBoard* board, const unsigned char values[BOARD_CELLS]) {
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        board->tiles[i].value = values[i];
+    }
+
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        board->rowValues[i] = ALL_CANDIDATES;
+        board->colValues[i] = ALL_CANDIDATES;
+        board->boxValues[i] = ALL_CANDIDATES;
+    }
+
+    for (int count = 0; count <= BOARD_SIZE; count++) {
+        for (int i = 0; i < TILE_SET_WORDS; i++) {
+            board->tilesByCount[count].words[i] = 0;
+        }
+    }
+
+    board->emptyCount = 0;
+    board->hasConflict = false;
+    board->hasDeadEnd = false;
+}
+
 /**
  * Gets a single Tile at the given row_i and col_i position
  * row_i and col_i are indexes where 0 <= i < BOARD_SIZE
@@ -168,21 +417,34 @@ void getBoardBox(SudokuBoard* board, int box_i, Tile box[BOX_SIZE][BOX_SIZE]) {
 }
 
 /**
- * Checks for duplicates
+ * Returns the character used to write the given value
+ * Values up to 9 are written as digits, larger values as letters starting
+ * from 'A' for 10. 0 (an empty tile) is written as '0'.
  */
-static bool isValid(Tile* row) {
-    bool found[BOARD_SIZE] = {false, false, false, false, false, false, false, false, false};
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        short value = row[i].value;
-        if (value == 0) {
-            continue;
-        }
-        if (found[value-1]) {
-            return false;
-        }
-        found[value-1] = true;
+char valueToCharacter(short value) {
+    return value < 10 ? '0' + value : 'A' + value - 10;
+}
+
+/**
+ * Returns the value written as the given character or -1 if the character
+ * does not represent a value on this board size
+ */
+short characterToValue(char c) {
+    short value;
+    if (c >= '0' && c <= '9') {
+        value = c - '0';
     }
-    return true;
+    else if (c >= 'A' && c <= 'Z') {
+        value = c - 'A' + 10;
+    }
+    else if (c >= 'a' && c <= 'z') {
+        value = c - 'a' + 10;
+    }
+    else {
+        return -1;
+    }
+
+    return value <= BOARD_SIZE ? value : -1;
 }
 
 /**
@@ -191,62 +453,23 @@ static bool isValid(Tile* row) {
  * A board is incorrect if it has any repetitions
  */
 bool isValidBoard(SudokuBoard* board) {
-    Tile row[BOARD_SIZE];
-    Tile col[BOARD_SIZE];
-    Tile box[BOX_SIZE][BOX_SIZE];
-
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        // validate box
-        getBoardBox(board, i, box);
-
-        Tile box_values[BOARD_SIZE];
-        for (int i = 0; i < BOX_SIZE; i++) {
-            for (int j = 0; j < BOX_SIZE; j++) {
-                box_values[i*BOX_SIZE + j] = box[i][j];
-            }
-        }
-
-        if (!isValid(box_values)) {
-            return false;
-        }
-
-        // validate column
-        getBoardColumn(board, i, col);
-        bool colValid = isValid(col);
-
-        if (!colValid) {
-            return false;
-        }
-
-        // validate row
-        getBoardRow(board, i, row);
-        bool rowValid = isValid(row);
-
-        if (!rowValid) {
-            return false;
-        }
-    }
-    return true;
+    // Repetitions are detected as values are placed
+    return !board->hasConflict;
 }
 
 /**
  * Returns whether you have a valid, complete board
  */
 bool isCompleteBoard(SudokuBoard* board) {
-    int index;
-
-    // make sure everything is full
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            index = coordinatesToTileIndex(i, j);
-
-            if (board->tiles[index].value == 0) {
-                return false;
-            }
-        }
-    }
+    return board->emptyCount == 0 && !board->hasConflict;
+}
 
-    return isValidBoard(board);
+/**
+ * Returns whether the board can no longer be completed: it has repetitions
+ * or an empty tile without any possible values
+ */
+bool isDeadEndBoard(SudokuBoard* board) {
+    return board->hasDeadEnd || board->hasConflict;
 }
 
 /**
@@ -254,22 +477,9 @@ bool isCompleteBoard(SudokuBoard* board) {
  * based on how difficult it is.
  */
 double getBoardDifficultyRating(SudokuBoard* board) {
-    int index;
-
     // More empty tiles = more difficult
-    double empty = 0;
-    // Loop through all tiles and count how many are already filled
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            index = coordinatesToTileIndex(i, j);
+    double empty = board->emptyCount;
 
-            if (board->tiles[index].value == 0) {
-                empty += 1;
-            }
-        }
-    }
-    
     // Returns the inverse divided by the maximum board size
     return empty / (BOARD_SIZE * BOARD_SIZE);
 }
-
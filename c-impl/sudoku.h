@@ -2,24 +2,129 @@
 #define __SUDOKU_DEFS
 
 #include <stdbool.h>
+#include <stdint.h>
 
 // The width/height of a single board and also the big board
+// Other board sizes are compiled separately by defining BOX_SIZE
+// (e.g. -DBOX_SIZE=4 for 16x16 boards)
+#ifndef BOX_SIZE
 #define BOX_SIZE 3
+#endif
 #define BOARD_SIZE (BOX_SIZE*BOX_SIZE)
+// The total number of tiles on the board
+#define BOARD_CELLS (BOARD_SIZE*BOARD_SIZE)
+
+// A set of values, one bit per value: bit (value - 1) is set if the value
+// is in the set. The smallest type that fits every value is used.
+#if BOARD_SIZE <= 16
+typedef uint16_t CandidateMask;
+#elif BOARD_SIZE <= 32
+typedef uint32_t CandidateMask;
+#elif BOARD_SIZE <= 64
+typedef uint64_t CandidateMask;
+#else
+#error "BOX_SIZE must be at most 8"
+#endif
+
+// The set of every value from 1 to BOARD_SIZE
+#define ALL_CANDIDATES ((CandidateMask)((CandidateMask)~(CandidateMask)0 >> (sizeof(CandidateMask) * 8 - BOARD_SIZE)))
+// The set containing only the given value
+#define CANDIDATE_BIT(value) ((CandidateMask)1 << ((value) - 1))
+
+/**
+ * Returns the number of values in the given set
+ * Defined here so it can be inlined into the solver's inner loops
+ */
+static inline int countCandidates(CandidateMask mask) {
+    return __builtin_popcountll(mask);
+}
+
+/**
+ * Returns the smallest value in the given set
+ * The set must not be empty
+ */
+static inline short lowestCandidate(CandidateMask mask) {
+    return __builtin_ctzll(mask) + 1;
+}
+
+/**
+ * Returns the largest value in the given set
+ * The set must not be empty
+ */
+static inline short highestCandidate(CandidateMask mask) {
+    return 64 - __builtin_clzll(mask);
+}
+
+/**
+ * Returns the index of the i-th tile of a unit
+ * Units 0 to BOARD_SIZE - 1 are rows, then columns, then boxes
+ * Defined here so that every module walking the units can inline it
+ */
+static inline int unitTile(int unit, int i) {
+    if (unit < BOARD_SIZE) {
+        return unit * BOARD_SIZE + i;
+    }
+    if (unit < 2 * BOARD_SIZE) {
+        return i * BOARD_SIZE + unit - BOARD_SIZE;
+    }
+    int box_i = unit - 2 * BOARD_SIZE;
+    int row_i = (box_i / BOX_SIZE) * BOX_SIZE + i / BOX_SIZE;
+    int col_i = (box_i % BOX_SIZE) * BOX_SIZE + i % BOX_SIZE;
+    return row_i * BOARD_SIZE + col_i;
+}
+
+#ifdef VARIANTS
+struct VariantRules;
+#endif
+
+// The number of 64 bit words needed for one bit per tile
+#define TILE_SET_WORDS ((BOARD_CELLS + 63) / 64)
+
+// A set of tiles, one bit per tile index (row_i * BOARD_SIZE + col_i)
+typedef struct {
+    uint64_t words[TILE_SET_WORDS];
+} TileSet;
+
+/**
+ * Returns the smallest tile index in the given set or -1 if it is empty
+ */
+static inline int firstTileInSet(const TileSet* set) {
+    for (int i = 0; i < TILE_SET_WORDS; i++) {
+        if (set->words[i] != 0) {
+            return i * 64 + __builtin_ctzll(set->words[i]);
+        }
+    }
+    return -1;
+}
 
 typedef struct {
     // The value of the tile
     short value;
-    // Each position in this array represents a valid value for this tile
-    // Each value is in the range 1 to BOARD_SIZE+1
-    // true if a value is available, false if a value cannot be used on this tile
-    bool possibleValues[BOARD_SIZE]; /* Not used if value != 0 */
-    // A cache of the number of true values in possibleValues
+    // Every value that can still be placed on this tile
+    CandidateMask possibleValues; /* Not used if value != 0 */
+    // A cache of the number of values in possibleValues
     int possibleCount; /* Not used if value != 0 */
 } Tile;
 
 typedef struct {
     Tile tiles[BOARD_SIZE * BOARD_SIZE];
+    // The number of tiles that do not have a value yet
+    int emptyCount;
+    // The values placed in every row, column and box
+    CandidateMask rowValues[BOARD_SIZE];
+    CandidateMask colValues[BOARD_SIZE];
+    CandidateMask boxValues[BOARD_SIZE];
+    // Set once a value is placed twice in the same row, column or box
+    bool hasConflict;
+    // Set once an empty tile has no possible values left
+    bool hasDeadEnd;
+    // Every empty tile, indexed by its possibleCount
+    TileSet tilesByCount[BOARD_SIZE + 1];
+#ifdef VARIANTS
+    // The extra rules of variant sudoku (see variants.c), NULL for classic
+    // boards
+    const struct VariantRules* rules;
+#endif
 } SudokuBoard;
 
 // Board initialization
@@ -33,17 +138,27 @@ void getBoardBox(SudokuBoard*, int, Tile[BOX_SIZE][BOX_SIZE]);
 
 // Board manipulation methods
 void placeSudokuValue(SudokuBoard*, int, int, short);
+bool eliminateSudokuValue(SudokuBoard*, int, int, short);
+void eraseSudokuValue(SudokuBoard*, int, int);
 
 // Bulk board manipulation methods
 void setBoardRow(SudokuBoard*, int, Tile[BOARD_SIZE]);
 void setBoardRowValues(SudokuBoard*, int, short[BOARD_SIZE]);
+void getBoardValues(SudokuBoard*, unsigned char[BOARD_CELLS]);
+void setBoardValues(SudokuBoard*, const unsigned char[BOARD_CELLS]);
+void setSolvedBoardValues(SudokuBoard*, const unsigned char[BOARD_CELLS]);
 
 // Utility functions
 void copySudokuBoard(SudokuBoard*, SudokuBoard*);
 double getBoardDifficultyRating(SudokuBoard*);
 
+// Text representation of values
+char valueToCharacter(short);
+short characterToValue(char);
+
 // Board validation methods
 bool isValidBoard(SudokuBoard*);
 bool isCompleteBoard(SudokuBoard*);
+bool isDeadEndBoard(SudokuBoard*);
 
 #endif
@@ -0,0 +1,117 @@
+/**
+ * An interactive sudoku solving session.
+ *
+ * Reads a board from stdin, followed by one command per line:
+ *
+ *     place row col value    Places a value (rows and columns count from 1)
+ *     erase row col          Erases the value of a tile
+ *     solvable               Prints "yes" if the board can still be solved
+ *     hint                   Prints the next value to place and why
+ *     solution               Prints a solution of the board
+ *     show                   Prints the board
+ *
+ * The givens of the board cannot be changed. Placing and erasing print "ok"
+ * or an error. This is meant to be driven by another program, so every
+ * answer is a single line or a single board.
+ *
+ * Usage: sudokusession < input
+ */
+
+#include <stdio.h>
+#include <stdlib.h> // EXIT_FAILURE, EXIT_SUCCESS
+#include <string.h>
+
+#include "sudoku.h"
+#include "drawboard.h"
+#include "boardparser.h"
+#include "session.h"
+
+// The longest command line that is read
+#define MAX_COMMAND 256
+
+static const char* stepNames[] = {
+    [STEP_NAKED_SINGLE] = "naked single",
+    [STEP_HIDDEN_SINGLE] = "hidden single",
+    [STEP_FROM_SOLUTION] = "from solution",
+};
+
+/**
+ * Converts the row and column of a command (counting from 1) to indexes
+ * Returns 0 if they are on the board, -1 otherwise
+ */
+static int toIndexes(int row, int col, int* row_i, int* col_i) {
+    if (row < 1 || row > BOARD_SIZE || col < 1 || col > BOARD_SIZE) {
+        return -1;
+    }
+    *row_i = row - 1;
+    *col_i = col - 1;
+    return 0;
+}
+
+int main(void) {
+    SudokuBoard board;
+    if (readBoard(stdin, &board) == -1 || !isValidBoard(&board)) {
+        printf("Invalid board.\n");
+        return EXIT_FAILURE;
+    }
+
+    SolverSession session;
+    startSolverSession(&session, &board);
+
+    char line[MAX_COMMAND];
+    while (fgets(line, MAX_COMMAND, stdin) != NULL) {
+        char command[MAX_COMMAND];
+        int row, col, value, row_i, col_i;
+        if (sscanf(line, "%s", command) != 1) {
+            continue;
+        }
+
+        if (strcmp(command, "place") == 0) {
+            if (sscanf(line, "%*s %d %d %d", &row, &col, &value) != 3
+                    || toIndexes(row, col, &row_i, &col_i) == -1
+                    || placeSessionValue(&session, row_i, col_i, value) == -1) {
+                printf("Cannot place there.\n");
+                continue;
+            }
+            printf("ok\n");
+        }
+        else if (strcmp(command, "erase") == 0) {
+            if (sscanf(line, "%*s %d %d", &row, &col) != 2
+                    || toIndexes(row, col, &row_i, &col_i) == -1
+                    || eraseSessionValue(&session, row_i, col_i) == -1) {
+                printf("Cannot erase there.\n");
+                continue;
+            }
+            printf("ok\n");
+        }
+        else if (strcmp(command, "solvable") == 0) {
+            printf(isSessionSolvable(&session) ? "yes\n" : "no\n");
+        }
+        else if (strcmp(command, "hint") == 0) {
+            SessionStep step;
+            if (findNextSessionStep(&session, &step) == -1) {
+                printf("No hint available.\n");
+                continue;
+            }
+            printf("%d %d %c (%s)\n", step.row_i + 1, step.col_i + 1,
+                valueToCharacter(step.value), stepNames[step.kind]);
+        }
+        else if (strcmp(command, "solution") == 0) {
+            SudokuBoard solution;
+            if (getSessionSolution(&session, &solution) == -1) {
+                printf("No solution found.\n");
+                continue;
+            }
+            drawSudokuBoardSimple(&solution);
+        }
+        else if (strcmp(command, "show") == 0) {
+            drawSudokuBoardSimple(&session.board);
+        }
+        else {
+            printf("Unknown command.\n");
+        }
+        fflush(stdout);
+    }
+
+    return EXIT_SUCCESS;
+}
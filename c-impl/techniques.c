@@ -0,0 +1,257 @@
+/**
+ * Logical solving techniques beyond singles
+ *
+ * Every technique only rules out possible values; it never places any.
+ * Tiles left with a single possible value are filled in by the solver's
+ * first tier afterwards.
+ *
+ * All of them look for a group of k lines (tiles or rows/columns) that
+ * together only leave room for k values (or positions). Those values (or
+ * positions) are then taken, so they can be ruled out everywhere else.
+ * Groups of two and three are searched for.
+ */
+#include "sudoku.h"
+#include "techniques.h"
+
+// Rows, columns and boxes
+#define UNIT_COUNT (3 * BOARD_SIZE)
+
+/**
+ * Rules out every value in values for the tile at index
+ * Returns the number of values that were ruled out
+ */
+static int eliminateValues(SudokuBoard* board, int index, CandidateMask values) {
+    int row_i = index / BOARD_SIZE;
+    int col_i = index % BOARD_SIZE;
+    int eliminated = 0;
+
+    values &= board->tiles[index].possibleValues;
+    while (values != 0) {
+        eliminated += eliminateSudokuValue(board, row_i, col_i, lowestCandidate(values));
+        values &= values - 1;
+    }
+    return eliminated;
+}
+
+/**
+ * Rules out values for every empty tile of the unit that is not in members
+ * (positions within the unit, one bit per position)
+ */
+static int eliminateFromUnit(SudokuBoard* board, int unit, CandidateMask members, CandidateMask values) {
+    int eliminated = 0;
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        int index = unitTile(unit, i);
+        if (!(members & CANDIDATE_BIT(i + 1)) && board->tiles[index].value == 0) {
+            eliminated += eliminateValues(board, index, values);
+        }
+    }
+    return eliminated;
+}
+
+/**
+ * Naked pairs and triples: k tiles of a unit that only have k possible
+ * values between them take those values away from the rest of the unit
+ *
+ * Returns the number of values ruled out, -1 if the board is a dead end
+ */
+int findNakedSubsets(SudokuBoard* board) {
+    int eliminated = 0;
+    for (int unit = 0; unit < UNIT_COUNT; unit++) {
+        // The empty tiles of the unit that have at most three values
+        short positions[BOARD_SIZE];
+        int count = 0;
+        int empty = 0;
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            Tile* tile = &board->tiles[unitTile(unit, i)];
+            if (tile->value != 0) {
+                continue;
+            }
+            empty++;
+            if (tile->possibleCount <= 3) {
+                positions[count++] = i;
+            }
+        }
+
+        for (int a = 0; a < count; a++) {
+            for (int b = a + 1; b < count; b++) {
+                CandidateMask pair = board->tiles[unitTile(unit, positions[a])].possibleValues
+                    | board->tiles[unitTile(unit, positions[b])].possibleValues;
+                CandidateMask pairMembers = CANDIDATE_BIT(positions[a] + 1) | CANDIDATE_BIT(positions[b] + 1);
+                int pairCount = countCandidates(pair);
+
+                if (pairCount == 2 && empty > 2) {
+                    eliminated += eliminateFromUnit(board, unit, pairMembers, pair);
+                    continue;
+                }
+                if (pairCount != 3 || empty <= 3) {
+                    continue;
+                }
+
+                for (int c = b + 1; c < count; c++) {
+                    CandidateMask triple = pair
+                        | board->tiles[unitTile(unit, positions[c])].possibleValues;
+                    if (countCandidates(triple) == 3) {
+                        eliminated += eliminateFromUnit(board, unit,
+                            pairMembers | CANDIDATE_BIT(positions[c] + 1), triple);
+                    }
+                }
+            }
+        }
+    }
+    return isDeadEndBoard(board) ? -1 : eliminated;
+}
+
+/**
+ * Hidden pairs and triples: k values that can only go on the same k tiles
+ * of a unit take those tiles, so no other values can go there
+ *
+ * Returns the number of values ruled out, -1 if the board is a dead end
+ */
+int findHiddenSubsets(SudokuBoard* board) {
+    int eliminated = 0;
+    for (int unit = 0; unit < UNIT_COUNT; unit++) {
+        // Where in the unit every value can go, one bit per position
+        CandidateMask places[BOARD_SIZE] = {0};
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            Tile* tile = &board->tiles[unitTile(unit, i)];
+            if (tile->value != 0) {
+                continue;
+            }
+            CandidateMask values = tile->possibleValues;
+            while (values != 0) {
+                places[lowestCandidate(values) - 1] |= CANDIDATE_BIT(i + 1);
+                values &= values - 1;
+            }
+        }
+
+        // The values that can go on two or three tiles
+        short values[BOARD_SIZE];
+        int count = 0;
+        for (int value = 0; value < BOARD_SIZE; value++) {
+            int placeCount = countCandidates(places[value]);
+            if (placeCount == 2 || placeCount == 3) {
+                values[count++] = value;
+            }
+        }
+
+        for (int a = 0; a < count; a++) {
+            for (int b = a + 1; b < count; b++) {
+                CandidateMask pair = places[values[a]] | places[values[b]];
+                CandidateMask pairValues = CANDIDATE_BIT(values[a] + 1) | CANDIDATE_BIT(values[b] + 1);
+                int pairCount = countCandidates(pair);
+
+                if (pairCount == 2) {
+                    eliminated += eliminateFromUnit(board, unit, ~pair, ~pairValues);
+                    continue;
+                }
+                if (pairCount != 3) {
+                    continue;
+                }
+
+                for (int c = b + 1; c < count; c++) {
+                    CandidateMask triple = pair | places[values[c]];
+                    if (countCandidates(triple) == 3) {
+                        eliminated += eliminateFromUnit(board, unit, ~triple,
+                            ~(pairValues | CANDIDATE_BIT(values[c] + 1)));
+                    }
+                }
+            }
+        }
+    }
+    return isDeadEndBoard(board) ? -1 : eliminated;
+}
+
+/**
+ * Rules out value for every empty tile where the crossing lines meet the
+ * lines that are not members. Lines are rows and crossing lines columns if
+ * byRows is true, the other way around otherwise.
+ */
+static int eliminateFromLines(SudokuBoard* board, short value, bool byRows,
+        CandidateMask members, CandidateMask crossLines) {
+    int eliminated = 0;
+    for (int line = 0; line < BOARD_SIZE; line++) {
+        if (members & CANDIDATE_BIT(line + 1)) {
+            continue;
+        }
+        CandidateMask crossing = crossLines;
+        while (crossing != 0) {
+            int cross = lowestCandidate(crossing) - 1;
+            crossing &= crossing - 1;
+            int row_i = byRows ? line : cross;
+            int col_i = byRows ? cross : line;
+            if (board->tiles[row_i * BOARD_SIZE + col_i].value == 0) {
+                eliminated += eliminateSudokuValue(board, row_i, col_i, value);
+            }
+        }
+    }
+    return eliminated;
+}
+
+/**
+ * X-Wing and Swordfish: if a value can only go in the same k columns in
+ * each of k rows, it must go in those columns in those rows, so it cannot
+ * go anywhere else in those columns (and the same with rows and columns
+ * swapped)
+ *
+ * Returns the number of values ruled out, -1 if the board is a dead end
+ */
+int findFish(SudokuBoard* board) {
+    int eliminated = 0;
+    for (short value = 1; value <= BOARD_SIZE; value++) {
+        CandidateMask valueBit = CANDIDATE_BIT(value);
+
+        for (int byRows = 0; byRows < 2; byRows++) {
+            // Where the value can go in every line that does not have it yet
+            CandidateMask places[BOARD_SIZE];
+            short lines[BOARD_SIZE];
+            int count = 0;
+            for (int line = 0; line < BOARD_SIZE; line++) {
+                CandidateMask placed = byRows ? board->rowValues[line] : board->colValues[line];
+                if (placed & valueBit) {
+                    continue;
+                }
+
+                CandidateMask linePlaces = 0;
+                for (int i = 0; i < BOARD_SIZE; i++) {
+                    int index = byRows ? line * BOARD_SIZE + i : i * BOARD_SIZE + line;
+                    Tile* tile = &board->tiles[index];
+                    if (tile->value == 0 && (tile->possibleValues & valueBit)) {
+                        linePlaces |= CANDIDATE_BIT(i + 1);
+                    }
+                }
+
+                int placeCount = countCandidates(linePlaces);
+                if (placeCount == 2 || placeCount == 3) {
+                    places[count] = linePlaces;
+                    lines[count] = line;
+                    count++;
+                }
+            }
+
+            for (int a = 0; a < count; a++) {
+                for (int b = a + 1; b < count; b++) {
+                    CandidateMask pair = places[a] | places[b];
+                    CandidateMask pairLines = CANDIDATE_BIT(lines[a] + 1) | CANDIDATE_BIT(lines[b] + 1);
+                    int pairCount = countCandidates(pair);
+
+                    if (pairCount == 2) {
+                        eliminated += eliminateFromLines(board, value, byRows, pairLines, pair);
+                        continue;
+                    }
+                    if (pairCount != 3) {
+                        continue;
+                    }
+
+                    for (int c = b + 1; c < count; c++) {
+                        CandidateMask triple = pair | places[c];
+                        if (countCandidates(triple) == 3) {
+                            eliminated += eliminateFromLines(board, value, byRows,
+                                pairLines | CANDIDATE_BIT(lines[c] + 1), triple);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return isDeadEndBoard(board) ? -1 : eliminated;
+}
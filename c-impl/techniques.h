@@ -0,0 +1,10 @@
+#ifndef __TECHNIQUES_DEFS
+#define __TECHNIQUES_DEFS
+
+#include "sudoku.h"
+
+int findNakedSubsets(SudokuBoard*);
+int findHiddenSubsets(SudokuBoard*);
+int findFish(SudokuBoard*);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef __TEMPLATES_DEFS
+#define __TEMPLATES_DEFS
+
+#include <stdint.h>
+
+// The number of ways to place one digit nine times on a 9x9 board, once in
+// every row, column and box
+#define TEMPLATE_COUNT 46656
+
+// Every template as three bands of 27 bits, with tile (row_i, col_i) at bit
+// (row_i % 3) * 9 + col_i of band row_i / 3 (like the bitboard engine).
+// templateBands[band][t] is band of template t. Generated by gentemplates.
+extern const uint32_t templateBands[3][TEMPLATE_COUNT];
+
+// Templates are listed in order of their first band, then their second
+// band, so templates with the same first band (or first two bands) come in
+// runs of this many. Runs can be skipped as a whole when one band does not
+// fit.
+#define TEMPLATES_PER_FIRST_BAND 288
+#define TEMPLATES_PER_SECOND_BAND 6
+
+#endif
@@ -0,0 +1,235 @@
+/**
+ * A solver for 9x9 boards that places whole digits at a time
+ *
+ * Every digit of a solved board is on one tile of every row, column and box.
+ * There are only 46,656 ways (templates) to do that, all generated at build
+ * time into templates.c. The engine first filters the templates of every
+ * digit against the board: a template fits if the digit can go on every one
+ * of its tiles. It then picks one template for every digit so that no two of
+ * them share a tile.
+ *
+ * That second step is a search over digits instead of tiles. The digit with
+ * the fewest fitting templates goes first. After every choice, the templates
+ * of the other digits that overlap it are filtered out, and the search backs
+ * up as soon as a digit has no templates left or some empty tile is not on
+ * any template that is left. Filtering is plain bitwise operations over long
+ * arrays, so how long it takes does not depend much on the order in which
+ * guesses happen to be made.
+ */
+#include <stdio.h>
+#include <stdlib.h> // malloc, free, exit, EXIT_FAILURE
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+#include "templates.h"
+#include "templatesolver.h"
+
+#if BOARD_SIZE == 9
+
+#define BANDS 3
+// Every tile of a band
+#define FULL_BAND 0x7FFFFFFu
+
+// The templates that still fit a digit
+typedef struct {
+    int digit;
+    int count;
+    // Indexes into templateBands
+    const int* templates;
+} DigitTemplates;
+
+// State shared by every level of a single search
+struct TemplateSearch {
+    // The template picked for every digit
+    int picked[BOARD_SIZE];
+    SolverStats* stats;
+};
+
+static void* allocate(size_t size) {
+    void* memory = malloc(size);
+    if (memory == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+static inline bool overlaps(int t, const uint32_t bands[BANDS]) {
+    return ((templateBands[0][t] & bands[0]) | (templateBands[1][t] & bands[1])
+        | (templateBands[2][t] & bands[2])) != 0;
+}
+
+/**
+ * Writes the index of every template that only uses the allowed tiles to
+ * templates and returns how many there are
+ */
+static int fittingTemplates(const uint32_t allowed[BANDS], int* templates) {
+    uint32_t blocked[BANDS] = {~allowed[0] & FULL_BAND, ~allowed[1] & FULL_BAND, ~allowed[2] & FULL_BAND};
+    int count = 0;
+
+    for (int first = 0; first < TEMPLATE_COUNT; first += TEMPLATES_PER_FIRST_BAND) {
+        if (templateBands[0][first] & blocked[0]) {
+            continue;
+        }
+        int firstEnd = first + TEMPLATES_PER_FIRST_BAND;
+        for (int second = first; second < firstEnd; second += TEMPLATES_PER_SECOND_BAND) {
+            if (templateBands[1][second] & blocked[1]) {
+                continue;
+            }
+            for (int t = second; t < second + TEMPLATES_PER_SECOND_BAND; t++) {
+                templates[count] = t;
+                count += (templateBands[2][t] & blocked[2]) == 0;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * Picks a template for each of the remaining digits of lists, none of which
+ * overlap each other or the occupied tiles. The templates in lists already
+ * do not overlap the occupied tiles. Filtered lists for deeper levels are
+ * written to buffer.
+ *
+ * Returns 0 if a template was picked for every digit, -1 otherwise
+ */
+static int combine(struct TemplateSearch* search, DigitTemplates* lists, int remaining,
+        const uint32_t occupied[BANDS], int* buffer) {
+    if (remaining == 0) {
+        return 0;
+    }
+
+    // The digit with the fewest templates goes first
+    int fewest = 0;
+    for (int i = 1; i < remaining; i++) {
+        if (lists[i].count < lists[fewest].count) {
+            fewest = i;
+        }
+    }
+    DigitTemplates digit = lists[fewest];
+    lists[fewest] = lists[remaining - 1];
+    remaining--;
+
+    DigitTemplates next[BOARD_SIZE];
+    for (int i = 0; i < digit.count; i++) {
+        int t = digit.templates[i];
+        search->stats->guesses++;
+
+        uint32_t taken[BANDS];
+        for (int band = 0; band < BANDS; band++) {
+            taken[band] = occupied[band] | templateBands[band][t];
+        }
+
+        // Every tile that is not taken yet must still be on some template
+        uint32_t covered[BANDS] = {taken[0], taken[1], taken[2]};
+        int* cursor = buffer;
+        bool fits = true;
+        for (int d = 0; d < remaining && fits; d++) {
+            next[d].digit = lists[d].digit;
+            next[d].templates = cursor;
+            for (int k = 0; k < lists[d].count; k++) {
+                int other = lists[d].templates[k];
+                *cursor = other;
+                if (!overlaps(other, taken)) {
+                    cursor++;
+                    for (int band = 0; band < BANDS; band++) {
+                        covered[band] |= templateBands[band][other];
+                    }
+                }
+            }
+            next[d].count = cursor - next[d].templates;
+            fits = next[d].count > 0;
+        }
+        if (!fits || covered[0] != FULL_BAND || covered[1] != FULL_BAND || covered[2] != FULL_BAND) {
+            continue;
+        }
+
+        if (combine(search, next, remaining, taken, cursor) == 0) {
+            search->picked[digit.digit] = t;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Solves a 9x9 board with the template engine
+ * options are not used. stats (if not NULL) is filled with the statistics
+ * of the search, with every template tried counted as a guess.
+ *
+ * Returns 0 if solving was successful, -1 otherwise
+ */
+int solveBoardTemplates(SudokuBoard* board, const SolverOptions* options, SolverStats* stats) {
+    SolverStats localStats;
+    if (stats == NULL) {
+        stats = &localStats;
+    }
+    *stats = (SolverStats) {0};
+
+    if (isDeadEndBoard(board)) {
+        return -1;
+    }
+
+    // The tiles every digit can go on: the tiles it is already on and the
+    // empty tiles where it is possible
+    uint32_t allowed[BOARD_SIZE][BANDS] = {{0}};
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        int row_i = i / BOARD_SIZE;
+        int col_i = i % BOARD_SIZE;
+        uint32_t bit = 1u << ((row_i % 3) * 9 + col_i);
+        Tile* tile = &board->tiles[i];
+        CandidateMask values = tile->value != 0 ? CANDIDATE_BIT(tile->value) : tile->possibleValues;
+        while (values != 0) {
+            allowed[lowestCandidate(values) - 1][row_i / 3] |= bit;
+            values &= values - 1;
+        }
+    }
+
+    int* fitting = allocate(BOARD_SIZE * TEMPLATE_COUNT * sizeof(int));
+    DigitTemplates lists[BOARD_SIZE];
+    int* cursor = fitting;
+    int total = 0;
+    int result = 0;
+    for (int digit = 0; digit < BOARD_SIZE; digit++) {
+        lists[digit].digit = digit;
+        lists[digit].templates = cursor;
+        lists[digit].count = fittingTemplates(allowed[digit], cursor);
+        cursor += lists[digit].count;
+        total += lists[digit].count;
+        if (lists[digit].count == 0) {
+            result = -1;
+        }
+    }
+
+    struct TemplateSearch search;
+    search.stats = stats;
+    uint32_t occupied[BANDS] = {0, 0, 0};
+    if (result == 0) {
+        // Every level of the search keeps at most as many templates as the
+        // level before, and there are BOARD_SIZE - 1 levels that keep any
+        int* buffer = allocate((BOARD_SIZE - 1) * total * sizeof(int));
+        result = combine(&search, lists, BOARD_SIZE, occupied, buffer);
+        free(buffer);
+    }
+    free(fitting);
+
+    if (result == -1) {
+        return -1;
+    }
+
+    for (int digit = 0; digit < BOARD_SIZE; digit++) {
+        int t = search.picked[digit];
+        for (int i = 0; i < BOARD_CELLS; i++) {
+            int row_i = i / BOARD_SIZE;
+            int col_i = i % BOARD_SIZE;
+            uint32_t bit = 1u << ((row_i % 3) * 9 + col_i);
+            if ((templateBands[row_i / 3][t] & bit) && board->tiles[i].value == 0) {
+                placeSudokuValue(board, row_i, col_i, digit + 1);
+            }
+        }
+    }
+    return isCompleteBoard(board) ? 0 : -1;
+}
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef __TEMPLATE_SOLVER_DEFS
+#define __TEMPLATE_SOLVER_DEFS
+
+#include "sudoku.h"
+#include "puzzlesolver.h"
+
+#if BOARD_SIZE == 9
+int solveBoardTemplates(SudokuBoard*, const SolverOptions*, SolverStats*);
+#endif
+
+#endif
@@ -1,6 +1,22 @@
 /**
  * Times the sudoku solver for every puzzle provided on stdin
  * Outputs a CSV file to stdout with the timing values
+ * Puzzles are read in either format of boardreader.c and may be gzip (or
+ * zstd) compressed. With --compress, the CSV file is compressed as well.
+ *
+ * With --checkpoint, the CSV file is written to the --output path and a
+ * checkpoint (see checkpoint.c) is saved every --checkpoint-interval puzzles,
+ * when the program is interrupted or terminated and at the end. Running the
+ * same command again with the same input resumes from the checkpoint: the
+ * output is cut back to what the checkpoint covers and the rest is appended,
+ * so no line is written twice.
+ *
+ * Usage: timesolvesudoku [--engine name] [--tie-break none|degree]
+ *                        [--probe-depth n] [--probe-limit n]
+ *                        [--techniques none|all|naked,hidden,fish] [--min-payoff x]
+ *                        [--portfolio-size n] [--guess-budget n]
+ *                        [--compress gzip|zstd] [--output path]
+ *                        [--checkpoint path [--checkpoint-interval n]]
  */
 
 // From: http://stackoverflow.com/a/3875233/551904
@@ -11,24 +27,234 @@
 #define _XOPEN_SOURCE 500
 #endif /* __STDC_VERSION__ */
 
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h> // exit, EXIT_FAILURE, EXIT_SUCCESS
+#include <string.h>
 #include <time.h>
+#include <fcntl.h>
+#include <unistd.h> // STDIN_FILENO
+#include <sys/stat.h>
 
 #include "sudoku.h"
 #include "drawboard.h"
-#include "boardparser.h"
+#include "boardreader.h"
+#include "checkpoint.h"
+#include "compressedstream.h"
 #include "puzzlesolver.h"
+#include "solverengine.h"
 
 #define BILLION  (1000000000L)
 
+#define DEFAULT_CHECKPOINT_INTERVAL 100000
+
+// Set when the program is asked to stop so that it can save a checkpoint
+// before it does
+static volatile sig_atomic_t stopRequested = 0;
+
+static void printUsage(char* program) {
+    fprintf(stderr, "Usage: %s [--engine ", program);
+    printSolverEngineNames(stderr);
+    fprintf(stderr, "] [--tie-break none|degree]\n"
+        "\t[--probe-depth n] [--probe-limit n]\n"
+        "\t[--techniques none|all|naked,hidden,fish] [--min-payoff x]\n"
+        "\t[--portfolio-size n] [--guess-budget n]\n"
+        "\t[--compress gzip|zstd] [--output path]\n"
+        "\t[--checkpoint path [--checkpoint-interval n]]\n");
+}
+
+static void requestStop(int signal) {
+    stopRequested = 1;
+}
+
+/**
+ * Points stdout at the file at path. Only the first size bytes of the file
+ * are kept and the output continues after them.
+ *
+ * Returns 0 if successful, -1 otherwise
+ */
+static int redirectOutput(const char* path, long size) {
+    int fd = open(path, O_WRONLY | O_CREAT, 0644);
+    if (fd == -1) {
+        perror(path);
+        return -1;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) == -1) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    // Checked before anything is changed, since ftruncate would pad the file
+    // with zeros up to the size of the checkpoint
+    if (status.st_size < size) {
+        fprintf(stderr, "%s: the output is shorter than the checkpoint\n", path);
+        close(fd);
+        return -1;
+    }
+
+    if (ftruncate(fd, size) == -1 || lseek(fd, size, SEEK_SET) == -1 || dup2(fd, STDOUT_FILENO) == -1) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+/**
+ * Flushes the output to disk and saves the progress up to the next board of
+ * the reader as a checkpoint at path
+ *
+ * Returns 0 if successful, -1 otherwise
+ */
+static int saveCheckpoint(const char* path, Checkpoint* progress, const BoardReader* reader) {
+    if (fflush(stdout) == EOF || fsync(STDOUT_FILENO) == -1) {
+        perror("output");
+        return -1;
+    }
+    progress->inputOffset = boardReaderOffset(reader);
+    progress->outputOffset = lseek(STDOUT_FILENO, 0, SEEK_CUR);
+    return writeCheckpoint(path, progress);
+}
+
+/**
+ * Parses a comma separated list of technique names into TECHNIQUE_* flags
+ *
+ * Returns 0 if successful, -1 if a name is unknown
+ */
+static int parseTechniques(char* list, unsigned int* techniques) {
+    *techniques = 0;
+    for (char* name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+        if (strcmp(name, "all") == 0) {
+            *techniques |= ALL_TECHNIQUES;
+        }
+        else if (strcmp(name, "naked") == 0) {
+            *techniques |= TECHNIQUE_NAKED_SUBSETS;
+        }
+        else if (strcmp(name, "hidden") == 0) {
+            *techniques |= TECHNIQUE_HIDDEN_SUBSETS;
+        }
+        else if (strcmp(name, "fish") == 0) {
+            *techniques |= TECHNIQUE_FISH;
+        }
+        else if (strcmp(name, "none") != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
-    printf("Puzzle Difficulty,Resolution (ns),Elapsed Time (ns)\n");
-    
-    int totalPuzzles = 0;
-    int completed = 0;
-    double averageSolveTime = 0;
-    double maxTime = 0;
+    SolverOptions options = defaultSolverOptions;
+    const SolverEngine* engine = defaultSolverEngine;
+    Compression outputCompression = COMPRESSION_NONE;
+    const char* outputPath = NULL;
+    const char* checkpointPath = NULL;
+    long checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tie-break") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "none") == 0) {
+                options.degreeTieBreak = false;
+            }
+            else if (strcmp(argv[i], "degree") == 0) {
+                options.degreeTieBreak = true;
+            }
+            else {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--probe-depth") == 0 && i + 1 < argc) {
+            options.probeDepth = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--probe-limit") == 0 && i + 1 < argc) {
+            options.probeLimit = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--techniques") == 0 && i + 1 < argc) {
+            if (parseTechniques(argv[++i], &options.techniques) == -1) {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--min-payoff") == 0 && i + 1 < argc) {
+            options.minTechniquePayoff = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--portfolio-size") == 0 && i + 1 < argc) {
+            options.portfolioSize = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--guess-budget") == 0 && i + 1 < argc) {
+            options.guessBudget = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            engine = findSolverEngine(argv[++i]);
+            if (engine == NULL) {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--compress") == 0 && i + 1 < argc) {
+            if (parseCompression(argv[++i], &outputCompression) == -1) {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpointPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--checkpoint-interval") == 0 && i + 1 < argc) {
+            checkpointInterval = atol(argv[++i]);
+        }
+        else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // A checkpoint needs an output file that can be cut back to it, which
+    // compressed output cannot be
+    if (checkpointPath != NULL && (outputPath == NULL || outputCompression != COMPRESSION_NONE
+            || checkpointInterval < 1)) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // The totals so far, which are also what is saved in checkpoints
+    Checkpoint progress = {0};
+    bool resuming = false;
+    if (checkpointPath != NULL) {
+        int found = readCheckpoint(checkpointPath, &progress);
+        if (found == -1) {
+            return EXIT_FAILURE;
+        }
+        resuming = found == 0;
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = requestStop;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+    }
+
+    if (outputPath != NULL && redirectOutput(outputPath, progress.outputOffset) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    OutputStream* output = NULL;
+    if (outputCompression != COMPRESSION_NONE && (output = startCompressedOutput(outputCompression)) == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    if (!resuming) {
+        printf("Puzzle Difficulty,Resolution (ns),Elapsed Time (ns)\n");
+    }
 
     struct timespec start, stop, res;
 
@@ -39,12 +265,40 @@ int main(int argc, char* argv[]) {
 
     double resolution = res.tv_sec * BILLION + res.tv_nsec;
 
+    InputStream* input = openInputStream(STDIN_FILENO);
+    if (input == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    if (resuming && skipInputStream(input, progress.inputOffset) == -1) {
+        fprintf(stderr, "The input is shorter than the checkpoint\n");
+        exit(EXIT_FAILURE);
+    }
+    BoardReader* reader = createBoardReaderFrom(readInputStream, input);
+    if (reader == NULL) {
+        fprintf(stderr, "Unable to allocate the input buffer\n");
+        exit(EXIT_FAILURE);
+    }
+    reader->inputRead = progress.inputOffset;
+
     int result;
     SudokuBoard board;
+    SolverStats stats;
+    long boardsSinceCheckpoint = 0;
     while (true) {
-        if (readBoard(stdin, &board) == -1) {
+        if (checkpointPath != NULL && (boardsSinceCheckpoint >= checkpointInterval || stopRequested)) {
+            if (saveCheckpoint(checkpointPath, &progress, reader) == -1) {
+                exit(EXIT_FAILURE);
+            }
+            boardsSinceCheckpoint = 0;
+            if (stopRequested) {
+                break;
+            }
+        }
+
+        if (readNextBoard(reader, &board) == -1) {
             break;
         }
+        boardsSinceCheckpoint++;
 
         if (!isValidBoard(&board)) {
             printf("Invalid board.\n");
@@ -58,7 +312,7 @@ int main(int argc, char* argv[]) {
             exit(EXIT_FAILURE);
         }
 
-        result = solveBoard(&board);
+        result = engine->solve(&board, &options, &stats);
 
         if (clock_gettime(CLOCK_MONOTONIC, &stop) == -1) {
             perror("clock gettime");
@@ -71,11 +325,16 @@ int main(int argc, char* argv[]) {
         printf("%lf,%lf,%lf\n", puzzleDifficulty, resolution, elapsedTime);
 
         // Take the running average
-        averageSolveTime = (averageSolveTime * totalPuzzles + elapsedTime)/(totalPuzzles + 1);
-        totalPuzzles++;
+        progress.averageSolveTime = (progress.averageSolveTime * progress.totalPuzzles + elapsedTime)
+            / (progress.totalPuzzles + 1);
+        progress.totalPuzzles++;
+        progress.totalGuesses += stats.guesses;
+        progress.totalProbes += stats.probes;
+        progress.totalEliminations += stats.eliminations;
+        progress.totalConflicts += stats.conflicts;
 
-        if (elapsedTime > maxTime) {
-            maxTime = elapsedTime;
+        if (elapsedTime > progress.maxTime) {
+            progress.maxTime = elapsedTime;
         }
 
         if (result == -1) {
@@ -83,13 +342,32 @@ int main(int argc, char* argv[]) {
             continue;
         }
         else {
-            completed++;
+            progress.completed++;
         }
     }
 
-    if (totalPuzzles > 0) {
-        fprintf(stderr, "Solved %d of %d puzzles (avg %f ns, max %f ns)\n", completed, totalPuzzles, averageSolveTime, maxTime);
+    int status = EXIT_SUCCESS;
+    if (stopRequested) {
+        fprintf(stderr, "Stopped, run again with --checkpoint %s to resume\n", checkpointPath);
+        status = EXIT_FAILURE;
+    }
+    else if (checkpointPath != NULL && saveCheckpoint(checkpointPath, &progress, reader) == -1) {
+        status = EXIT_FAILURE;
+    }
+    freeBoardReader(reader);
+    if (closeInputStream(input) == -1) {
+        status = EXIT_FAILURE;
+    }
+
+    if (progress.totalPuzzles > 0) {
+        fprintf(stderr, "Solved %d of %d puzzles (avg %f ns, max %f ns, %ld guesses, %ld probes, %ld eliminations, %ld conflicts)\n",
+            progress.completed, progress.totalPuzzles, progress.averageSolveTime, progress.maxTime,
+            progress.totalGuesses, progress.totalProbes, progress.totalEliminations, progress.totalConflicts);
+    }
+
+    if (output != NULL && finishCompressedOutput(output) == -1) {
+        status = EXIT_FAILURE;
     }
 
-    return EXIT_SUCCESS;
+    return status;
 }
@@ -0,0 +1,313 @@
+/**
+ * Variant sudoku: extra rules on top of rows, columns and boxes
+ *
+ * A board can be preceded by rule lines starting with '@':
+ *
+ *     @diagonal                 Both main diagonals are units
+ *     @windoku                  The windows between the boxes (rows and
+ *                               columns 2-4 and 6-8 on a 9x9 board) are units
+ *     @antiknight               Tiles a knight's move apart differ
+ *     @cage 15 1,1 1,2 2,1      Killer cage: the tiles (row,column counting
+ *                               from 1) differ and add up to the sum
+ *
+ * The rules of a board are compiled into a table with the extra peers of
+ * every tile: the tiles outside of its row, column and box that cannot have
+ * the same value. Placing a value rules it out for those tiles as well, so
+ * every solver built on placeSudokuValue handles variants without changes.
+ * Cages also rule out the values that no longer fit their sum.
+ *
+ * All of this is only compiled in with -DVARIANTS, so classic boards in the
+ * regular build pay nothing for it.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h> // atoi
+
+#include "sudoku.h"
+#include "variants.h"
+
+#ifdef VARIANTS
+
+// The longest rule line that is read
+#define MAX_RULE_LINE 1024
+
+static inline bool sameHouse(int a, int b) {
+    int rowA = a / BOARD_SIZE, colA = a % BOARD_SIZE;
+    int rowB = b / BOARD_SIZE, colB = b % BOARD_SIZE;
+    return rowA == rowB || colA == colB
+        || (rowA / BOX_SIZE == rowB / BOX_SIZE && colA / BOX_SIZE == colB / BOX_SIZE);
+}
+
+/**
+ * Makes every pair of the given tiles peers (unless they already share a
+ * row, column or box)
+ */
+static void addUnitPeers(const short* tiles, int count, bool peers[BOARD_CELLS][BOARD_CELLS]) {
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < count; j++) {
+            if (i != j && !sameHouse(tiles[i], tiles[j])) {
+                peers[tiles[i]][tiles[j]] = true;
+            }
+        }
+    }
+}
+
+/**
+ * Fills in the extra peers of every tile from the variants and cages
+ */
+static void compilePeers(VariantRules* rules) {
+    static bool peers[BOARD_CELLS][BOARD_CELLS];
+    memset(peers, 0, sizeof(peers));
+
+    short unit[BOARD_SIZE];
+    if (rules->variants & VARIANT_DIAGONAL) {
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            unit[i] = i * BOARD_SIZE + i;
+        }
+        addUnitPeers(unit, BOARD_SIZE, peers);
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            unit[i] = i * BOARD_SIZE + BOARD_SIZE - 1 - i;
+        }
+        addUnitPeers(unit, BOARD_SIZE, peers);
+    }
+
+    if (rules->variants & VARIANT_WINDOKU) {
+        // Windows start one tile into every box but the last
+        for (int top = 1; top + BOX_SIZE < BOARD_SIZE; top += BOX_SIZE + 1) {
+            for (int left = 1; left + BOX_SIZE < BOARD_SIZE; left += BOX_SIZE + 1) {
+                for (int i = 0; i < BOARD_SIZE; i++) {
+                    unit[i] = (top + i / BOX_SIZE) * BOARD_SIZE + left + i % BOX_SIZE;
+                }
+                addUnitPeers(unit, BOARD_SIZE, peers);
+            }
+        }
+    }
+
+    if (rules->variants & VARIANT_ANTI_KNIGHT) {
+        static const int moves[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+        for (int i = 0; i < BOARD_CELLS; i++) {
+            for (int m = 0; m < 8; m++) {
+                int row_i = i / BOARD_SIZE + moves[m][0];
+                int col_i = i % BOARD_SIZE + moves[m][1];
+                if (row_i < 0 || row_i >= BOARD_SIZE || col_i < 0 || col_i >= BOARD_SIZE) {
+                    continue;
+                }
+                int other = row_i * BOARD_SIZE + col_i;
+                if (!sameHouse(i, other)) {
+                    peers[i][other] = true;
+                }
+            }
+        }
+    }
+
+    for (int c = 0; c < rules->cageCount; c++) {
+        addUnitPeers(rules->cages[c].tiles, rules->cages[c].size, peers);
+    }
+
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        rules->peerCounts[i] = 0;
+        for (int j = 0; j < BOARD_CELLS; j++) {
+            if (peers[i][j]) {
+                rules->peers[i][rules->peerCounts[i]++] = j;
+            }
+        }
+    }
+}
+
+/**
+ * Parses a cage rule (without the "@cage" at the start) using strtok
+ * Returns 0 if the operation was successful and -1 if there was a parse
+ * error
+ */
+static int parseCage(VariantRules* rules) {
+    const char* sum = strtok(NULL, " \t\n");
+    if (sum == NULL) {
+        return -1;
+    }
+    Cage* cage = &rules->cages[rules->cageCount];
+    cage->sum = atoi(sum);
+    cage->size = 0;
+
+    const char* tile;
+    while ((tile = strtok(NULL, " \t\n")) != NULL) {
+        int row, col;
+        if (cage->size == BOARD_SIZE || sscanf(tile, "%d,%d", &row, &col) != 2
+                || row < 1 || row > BOARD_SIZE || col < 1 || col > BOARD_SIZE) {
+            return -1;
+        }
+        int index = (row - 1) * BOARD_SIZE + col - 1;
+        if (rules->tileCages[index] != -1) {
+            // Every tile is in at most one cage
+            return -1;
+        }
+        rules->tileCages[index] = rules->cageCount;
+        cage->tiles[cage->size++] = index;
+    }
+
+    if (cage->size == 0) {
+        return -1;
+    }
+    rules->cageCount++;
+    return 0;
+}
+
+/**
+ * Reads the rule lines (starting with '@') in front of a board and compiles
+ * them into rules. A board without rule lines gets no variants or cages.
+ *
+ * Returns 0 if the operation was successful and -1 if there was a parse
+ * error
+ */
+int readVariantRules(FILE* fp, VariantRules* rules) {
+    rules->variants = 0;
+    rules->cageCount = 0;
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        rules->tileCages[i] = -1;
+    }
+
+    char line[MAX_RULE_LINE];
+    while (true) {
+        int c = getc(fp);
+        if (c != '@') {
+            if (c != EOF) {
+                ungetc(c, fp);
+            }
+            break;
+        }
+        if (fgets(line, MAX_RULE_LINE, fp) == NULL) {
+            return -1;
+        }
+
+        const char* name = strtok(line, " \t\n");
+        if (name == NULL) {
+            return -1;
+        }
+        else if (strcmp(name, "diagonal") == 0) {
+            rules->variants |= VARIANT_DIAGONAL;
+        }
+        else if (strcmp(name, "windoku") == 0) {
+            rules->variants |= VARIANT_WINDOKU;
+        }
+        else if (strcmp(name, "antiknight") == 0) {
+            rules->variants |= VARIANT_ANTI_KNIGHT;
+        }
+        else if (strcmp(name, "cage") == 0) {
+            if (parseCage(rules) == -1) {
+                return -1;
+            }
+        }
+        else {
+            return -1;
+        }
+    }
+
+    if (rules->variants != 0 || rules->cageCount > 0) {
+        compilePeers(rules);
+    }
+    return 0;
+}
+
+/**
+ * Adds the values of every set of count values from available that adds up
+ * to sum to values
+ *
+ * Returns whether there was any such set
+ */
+static bool findCageValues(CandidateMask available, int count, int sum, CandidateMask* values) {
+    if (count == 0) {
+        return sum == 0;
+    }
+    if (available == 0 || sum <= 0) {
+        return false;
+    }
+
+    short value = highestCandidate(available);
+    CandidateMask rest = available & ~CANDIDATE_BIT(value);
+    bool found = false;
+    if (value <= sum && findCageValues(rest, count - 1, sum - value, values)) {
+        *values |= CANDIDATE_BIT(value);
+        found = true;
+    }
+    if (findCageValues(rest, count, sum, values)) {
+        found = true;
+    }
+    return found;
+}
+
+/**
+ * Rules out the values that cannot be part of the sum of the cage for its
+ * empty tiles, and marks the board as conflicting if the values placed in
+ * the cage can no longer add up to its sum
+ */
+static void restrictCage(SudokuBoard* board, const Cage* cage) {
+    CandidateMask placed = 0;
+    int sum = 0;
+    int empty = 0;
+    for (int i = 0; i < cage->size; i++) {
+        short value = board->tiles[cage->tiles[i]].value;
+        if (value != 0) {
+            placed |= CANDIDATE_BIT(value);
+            sum += value;
+        }
+        else {
+            empty++;
+        }
+    }
+
+    if (empty == 0) {
+        if (sum != cage->sum) {
+            board->hasConflict = true;
+        }
+        return;
+    }
+
+    CandidateMask allowed = 0;
+    if (!findCageValues(ALL_CANDIDATES & ~placed, empty, cage->sum - sum, &allowed)) {
+        board->hasConflict = true;
+    }
+    for (int i = 0; i < cage->size; i++) {
+        int index = cage->tiles[i];
+        if (board->tiles[index].value != 0) {
+            continue;
+        }
+        CandidateMask ruledOut = board->tiles[index].possibleValues & ~allowed;
+        while (ruledOut != 0) {
+            eliminateSudokuValue(board, index / BOARD_SIZE, index % BOARD_SIZE, lowestCandidate(ruledOut));
+            ruledOut &= ruledOut - 1;
+        }
+    }
+}
+
+/**
+ * Makes the board follow the rules. Must be called on an empty board,
+ * before any value is placed. The rules must stay valid for as long as the
+ * board (or any copy of it) is used.
+ */
+void applyVariantRules(SudokuBoard* board, const VariantRules* rules) {
+    board->rules = rules;
+    for (int c = 0; c < rules->cageCount; c++) {
+        restrictCage(board, &rules->cages[c]);
+    }
+}
+
+/**
+ * Applies the board's rules to a value that was just placed on the tile at
+ * index (called by placeSudokuValue)
+ */
+void placeVariantValue(SudokuBoard* board, int index, short value) {
+    const VariantRules* rules = board->rules;
+    for (int i = 0; i < rules->peerCounts[index]; i++) {
+        int peer = rules->peers[index][i];
+        if (board->tiles[peer].value == value) {
+            board->hasConflict = true;
+        }
+        eliminateSudokuValue(board, peer / BOARD_SIZE, peer % BOARD_SIZE, value);
+    }
+
+    int cage = rules->tileCages[index];
+    if (cage != -1) {
+        restrictCage(board, &rules->cages[cage]);
+    }
+}
+
+#endif
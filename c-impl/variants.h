@@ -0,0 +1,47 @@
+#ifndef __VARIANTS_DEFS
+#define __VARIANTS_DEFS
+
+#include <stdio.h>
+
+#include "sudoku.h"
+
+// Only compiled into variant builds (-DVARIANTS, see variants.c)
+#ifdef VARIANTS
+
+// Variants with fixed extra rules
+#define VARIANT_DIAGONAL 1
+#define VARIANT_WINDOKU 2
+#define VARIANT_ANTI_KNIGHT 4
+
+// The most tiles outside of a tile's row, column and box that can share a
+// unit with it: two diagonals, a window, a cage and eight knight moves
+#define MAX_EXTRA_PEERS (4 * (BOARD_SIZE - 1) + 8)
+
+// Tiles whose values must all be different and add up to sum
+typedef struct {
+    int sum;
+    int size;
+    short tiles[BOARD_SIZE];
+} Cage;
+
+struct VariantRules {
+    // VARIANT_* flags
+    unsigned int variants;
+    int cageCount;
+    Cage cages[BOARD_CELLS];
+    // The cage every tile is in, -1 if it is not in one
+    short tileCages[BOARD_CELLS];
+    // The tiles that cannot have the same value as each tile, apart from
+    // the ones in its row, column and box
+    short peerCounts[BOARD_CELLS];
+    short peers[BOARD_CELLS][MAX_EXTRA_PEERS];
+};
+typedef struct VariantRules VariantRules;
+
+int readVariantRules(FILE*, VariantRules*);
+void applyVariantRules(SudokuBoard*, const VariantRules*);
+void placeVariantValue(SudokuBoard*, int, short);
+
+#endif
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ * Checks filled or partially filled grids for conflicts without setting up
+ * a SudokuBoard for them
+ *
+ * A grid is checked with one bitmask per row, column and box: every value
+ * sets its bit, and a bit that is already set is a repeated value. Values
+ * are shifted into bits as they are (bit 0 is an empty tile) so that no
+ * branch is needed for empty tiles.
+ *
+ * verifyGridBatch does the same for VERIFY_LANES grids at once. The grids of
+ * a batch are stored tile by tile, so with GCC's vector extensions every
+ * step of the check is a single operation over every grid of the batch.
+ * Compilers without them (or builds with -DNO_SIMD) check the grids of a
+ * batch one by one instead.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sudoku.h"
+#include "verifier.h"
+
+// One bit per value and bit 0 for empty tiles
+#if BOARD_SIZE < 16
+typedef uint16_t UnitMask;
+#else
+typedef uint32_t UnitMask;
+#endif
+
+// The bits of the values that are not empty
+#define VALUE_BITS ((UnitMask)~(UnitMask)1)
+
+// Tables filled in once by fillTables, on first use
+// The tiles of every unit
+static short unitTiles[3 * BOARD_SIZE][BOARD_SIZE];
+static pthread_once_t tablesOnce = PTHREAD_ONCE_INIT;
+
+static void fillTables(void) {
+    for (int unit = 0; unit < 3 * BOARD_SIZE; unit++) {
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            unitTiles[unit][i] = unitTile(unit, i);
+        }
+    }
+}
+
+/**
+ * Fills in the tables if no thread has done so yet. Every thread that calls
+ * this waits until they are filled in.
+ */
+static void prepareTables(void) {
+    pthread_once(&tablesOnce, fillTables);
+}
+
+/**
+ * Sets the given lane of a batch to the tile values of a grid (0 for empty
+ * tiles)
+ */
+void setGridLane(GridBatch* batch, int lane, const unsigned char values[BOARD_CELLS]) {
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        batch->values[i][lane] = values[i];
+    }
+}
+
+/**
+ * Empties every tile of the given lane of a batch
+ */
+void clearGridLane(GridBatch* batch, int lane) {
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        batch->values[i][lane] = 0;
+    }
+}
+
+/**
+ * Checks a single grid. If givens is not NULL, every value in it must also
+ * be in values.
+ */
+GridStatus verifyGridValues(const unsigned char values[BOARD_CELLS], const unsigned char* givens) {
+    prepareTables();
+
+    UnitMask repeated = 0;
+    UnitMask present = 0;
+    for (int unit = 0; unit < 3 * BOARD_SIZE; unit++) {
+        UnitMask seen = 0;
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            UnitMask bit = (UnitMask)1 << values[unitTiles[unit][i]];
+            repeated |= seen & bit;
+            seen |= bit;
+        }
+        present |= seen;
+    }
+
+    bool changed = false;
+    if (givens != NULL) {
+        for (int i = 0; i < BOARD_CELLS; i++) {
+            changed |= givens[i] != 0 && givens[i] != values[i];
+        }
+    }
+
+    if ((repeated & VALUE_BITS) || changed) {
+        return GRID_INVALID;
+    }
+    return (present & 1) ? GRID_VALID : GRID_SOLVED;
+}
+
+#if defined(__GNUC__) && !defined(NO_SIMD)
+
+typedef unsigned char LaneValues __attribute__((vector_size(VERIFY_LANES)));
+typedef UnitMask LaneMasks __attribute__((vector_size(VERIFY_LANES * sizeof(UnitMask))));
+typedef int32_t LaneInts __attribute__((vector_size(VERIFY_LANES * sizeof(int32_t))));
+typedef float LaneFloats __attribute__((vector_size(VERIFY_LANES * sizeof(float))));
+
+static inline LaneValues loadLanes(const unsigned char lanes[VERIFY_LANES]) {
+    LaneValues values;
+    memcpy(&values, lanes, sizeof(values));
+    return values;
+}
+
+/**
+ * Checks VERIFY_LANES grids at once and writes the status of every grid to
+ * statuses. If givens is not NULL, every value of a lane in it must also be
+ * in the same lane of grids (use empty lanes for grids without givens).
+ */
+void verifyGridBatch(const GridBatch* grids, const GridBatch* givens, GridStatus statuses[VERIFY_LANES]) {
+    prepareTables();
+
+    LaneMasks bits[BOARD_CELLS];
+    LaneMasks changed = {0};
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        // SSE2 cannot shift every lane by a different amount, so the bit of
+        // each value is made as the float 2^value (value + 127 is its
+        // exponent) and converted back to an integer
+        LaneValues values = loadLanes(grids->values[i]);
+        LaneInts exponents = (__builtin_convertvector(values, LaneInts) + 127) << 23;
+        bits[i] = __builtin_convertvector(__builtin_convertvector((LaneFloats)exponents, LaneInts), LaneMasks);
+        if (givens != NULL) {
+            LaneValues given = loadLanes(givens->values[i]);
+            changed |= __builtin_convertvector((given != 0) & (given != values), LaneMasks);
+        }
+    }
+
+    LaneMasks repeated = changed;
+    LaneMasks present = {0};
+    for (int unit = 0; unit < 3 * BOARD_SIZE; unit++) {
+        LaneMasks seen = {0};
+        for (int i = 0; i < BOARD_SIZE; i++) {
+            LaneMasks bit = bits[unitTiles[unit][i]];
+            repeated |= seen & bit;
+            seen |= bit;
+        }
+        present |= seen;
+    }
+
+    for (int lane = 0; lane < VERIFY_LANES; lane++) {
+        if (repeated[lane] & VALUE_BITS) {
+            statuses[lane] = GRID_INVALID;
+        }
+        else {
+            statuses[lane] = (present[lane] & 1) ? GRID_VALID : GRID_SOLVED;
+        }
+    }
+}
+
+#else
+
+/**
+ * Checks VERIFY_LANES grids and writes the status of every grid to statuses
+ * If givens is not NULL, every value of a lane in it must also be in the same
+ * lane of grids (use empty lanes for grids without givens).
+ */
+void verifyGridBatch(const GridBatch* grids, const GridBatch* givens, GridStatus statuses[VERIFY_LANES]) {
+    for (int lane = 0; lane < VERIFY_LANES; lane++) {
+        unsigned char values[BOARD_CELLS];
+        unsigned char laneGivens[BOARD_CELLS];
+        for (int i = 0; i < BOARD_CELLS; i++) {
+            values[i] = grids->values[i][lane];
+            if (givens != NULL) {
+                laneGivens[i] = givens->values[i][lane];
+            }
+        }
+        statuses[lane] = verifyGridValues(values, givens != NULL ? laneGivens : NULL);
+    }
+}
+
+#endif
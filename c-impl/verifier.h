@@ -0,0 +1,31 @@
+#ifndef __VERIFIER_DEFS
+#define __VERIFIER_DEFS
+
+#include "sudoku.h"
+
+// The number of grids checked together by verifyGridBatch
+#define VERIFY_LANES 16
+
+typedef enum {
+    // A value is repeated in a unit, a given was changed or the grid could
+    // not be parsed
+    GRID_INVALID,
+    // No conflicts, but some tiles are empty
+    GRID_VALID,
+    // No conflicts and every tile is filled
+    GRID_SOLVED,
+} GridStatus;
+
+// Grids stored tile by tile so that the same tile of every grid is next to
+// each other: values[i][lane] is tile i of grid lane
+typedef struct {
+    unsigned char values[BOARD_CELLS][VERIFY_LANES];
+} GridBatch;
+
+void setGridLane(GridBatch*, int, const unsigned char[BOARD_CELLS]);
+void clearGridLane(GridBatch*, int);
+
+GridStatus verifyGridValues(const unsigned char[BOARD_CELLS], const unsigned char*);
+void verifyGridBatch(const GridBatch*, const GridBatch*, GridStatus[VERIFY_LANES]);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef __SUDOKU_CAPI_DEFS
+#define __SUDOKU_CAPI_DEFS
+
+/**
+ * The C API of the Rust solver (see "C API" in ../../README.md)
+ *
+ * Boards are arrays of SUDOKU_CELLS values stored row by row, 0 for empty
+ * tiles. Every buffer is owned by the caller and no function allocates or
+ * keeps a pointer after it returns, so the functions can be called from any
+ * number of threads at once on different boards.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Compare with sudoku_api_version() to check the library that was linked
+#define SUDOKU_API_VERSION 1
+
+// The number of tiles of a board
+#define SUDOKU_CELLS 81
+// The number of characters of a board in the text format: 9 lines of 9
+// digits, each ending with '\n'
+#define SUDOKU_TEXT_SIZE 90
+
+// Result codes
+#define SUDOKU_OK 0
+// sudoku_validate: no conflicts, but some tiles are empty
+#define SUDOKU_INCOMPLETE 1
+#define SUDOKU_PARSE_ERROR -1
+// A value is repeated in a row, column or box or is out of range
+#define SUDOKU_INVALID_BOARD -2
+#define SUDOKU_NO_SOLUTION -3
+
+uint32_t sudoku_api_version(void);
+
+// Parses SUDOKU_TEXT_SIZE characters into a board
+int32_t sudoku_parse(const char*, uint8_t[SUDOKU_CELLS]);
+// Solves a board in place, which is only changed if it was solved
+int32_t sudoku_solve(uint8_t[SUDOKU_CELLS]);
+// Solves count boards stored one after another in place, writes the result
+// of every board to results (if it is not NULL) and returns the number of
+// boards that were solved
+size_t sudoku_solve_batch(uint8_t*, size_t, int32_t*);
+// Returns SUDOKU_OK for a solved board, SUDOKU_INCOMPLETE or
+// SUDOKU_INVALID_BOARD
+int32_t sudoku_validate(const uint8_t[SUDOKU_CELLS]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
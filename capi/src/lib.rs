@@ -0,0 +1,163 @@
+//! A C API for the solver (declared in include/sudoku_capi.h)
+//!
+//! Boards are passed as arrays of SUDOKU_CELLS values stored row by row with 0 for empty tiles.
+//! The caller owns every buffer and no function allocates, so boards are never copied into
+//! memory owned by this library. Every function returns one of the SUDOKU_* result codes.
+
+extern crate sudoku;
+
+use std::num::NonZeroU8;
+use std::slice;
+
+use sudoku::{Pos, Sudoku};
+
+/// The width and height of the board
+const BOARD_SIZE: usize = 9;
+/// The number of tiles of a board (SUDOKU_CELLS)
+const CELLS: usize = BOARD_SIZE * BOARD_SIZE;
+/// The size of a board in the text format (SUDOKU_TEXT_SIZE): 9 lines of 9 digits
+const TEXT_SIZE: usize = CELLS + BOARD_SIZE;
+
+/// Bumped whenever a function or result code changes in a way that is not backwards compatible
+const API_VERSION: u32 = 1;
+
+const SUDOKU_OK: i32 = 0;
+const SUDOKU_INCOMPLETE: i32 = 1;
+const SUDOKU_PARSE_ERROR: i32 = -1;
+const SUDOKU_INVALID_BOARD: i32 = -2;
+const SUDOKU_NO_SOLUTION: i32 = -3;
+
+/// Places the values of a board, failing if a value is out of range
+fn load_board(values: &[u8]) -> Result<Sudoku, i32> {
+    let mut board = Sudoku::default();
+    for (i, &value) in values.iter().enumerate() {
+        if value as usize > BOARD_SIZE {
+            return Err(SUDOKU_INVALID_BOARD);
+        }
+        if let Some(value) = NonZeroU8::new(value) {
+            board.place(Pos {row: i / BOARD_SIZE, col: i % BOARD_SIZE}, value);
+        }
+    }
+    Ok(board)
+}
+
+/// Writes the values of a board back into the caller's buffer
+fn store_board(board: &Sudoku, values: &mut [u8]) {
+    for (i, value) in values.iter_mut().enumerate() {
+        *value = board.value(Pos {row: i / BOARD_SIZE, col: i % BOARD_SIZE}).map_or(0, |value| value.get());
+    }
+}
+
+fn solve_values(values: &mut [u8]) -> i32 {
+    let mut board = match load_board(values) {
+        Ok(board) => board,
+        Err(result) => return result,
+    };
+    if !board.is_valid() {
+        return SUDOKU_INVALID_BOARD;
+    }
+    if board.solve().is_err() {
+        return SUDOKU_NO_SOLUTION;
+    }
+
+    store_board(&board, values);
+    SUDOKU_OK
+}
+
+/// Returns the version of the API implemented by this library (SUDOKU_API_VERSION of the header
+/// it was built with)
+#[no_mangle]
+pub extern "C" fn sudoku_api_version() -> u32 {
+    API_VERSION
+}
+
+/// Parses SUDOKU_TEXT_SIZE characters of text (9 lines of 9 digits, 0 for empty tiles, each
+/// ending with '\n') into values
+///
+/// Returns SUDOKU_OK or SUDOKU_PARSE_ERROR (values is left unchanged)
+#[no_mangle]
+pub unsafe extern "C" fn sudoku_parse(text: *const u8, values: *mut u8) -> i32 {
+    if text.is_null() || values.is_null() {
+        return SUDOKU_PARSE_ERROR;
+    }
+    let text = slice::from_raw_parts(text, TEXT_SIZE);
+
+    let mut parsed = [0; CELLS];
+    for (row_i, line) in text.chunks(BOARD_SIZE + 1).enumerate() {
+        if line[BOARD_SIZE] != b'\n' {
+            return SUDOKU_PARSE_ERROR;
+        }
+        for (col_i, &c) in line[..BOARD_SIZE].iter().enumerate() {
+            if !c.is_ascii_digit() {
+                return SUDOKU_PARSE_ERROR;
+            }
+            parsed[row_i * BOARD_SIZE + col_i] = c - b'0';
+        }
+    }
+
+    slice::from_raw_parts_mut(values, CELLS).copy_from_slice(&parsed);
+    SUDOKU_OK
+}
+
+/// Solves the board in values in place
+///
+/// Returns SUDOKU_OK, SUDOKU_INVALID_BOARD if a value is repeated or out of range or
+/// SUDOKU_NO_SOLUTION. values is only changed if the board was solved.
+#[no_mangle]
+pub unsafe extern "C" fn sudoku_solve(values: *mut u8) -> i32 {
+    if values.is_null() {
+        return SUDOKU_INVALID_BOARD;
+    }
+    solve_values(slice::from_raw_parts_mut(values, CELLS))
+}
+
+/// Solves count boards stored one after another in values (count * SUDOKU_CELLS values) in place.
+/// If results is not NULL, the result of every board (as returned by sudoku_solve) is written to
+/// it.
+///
+/// Returns the number of boards that were solved
+#[no_mangle]
+pub unsafe extern "C" fn sudoku_solve_batch(values: *mut u8, count: usize, results: *mut i32) -> usize {
+    if values.is_null() || count == 0 {
+        return 0;
+    }
+    let boards = slice::from_raw_parts_mut(values, count * CELLS);
+    let mut results = if results.is_null() { None } else { Some(slice::from_raw_parts_mut(results, count)) };
+
+    let mut solved = 0;
+    for (i, board) in boards.chunks_mut(CELLS).enumerate() {
+        let result = solve_values(board);
+        if result == SUDOKU_OK {
+            solved += 1;
+        }
+        if let Some(ref mut results) = results {
+            results[i] = result;
+        }
+    }
+    solved
+}
+
+/// Checks the board in values without changing it
+///
+/// Returns SUDOKU_OK if it is completely and correctly filled, SUDOKU_INCOMPLETE if it has no
+/// conflicts but some tiles are empty and SUDOKU_INVALID_BOARD otherwise
+#[no_mangle]
+pub unsafe extern "C" fn sudoku_validate(values: *const u8) -> i32 {
+    if values.is_null() {
+        return SUDOKU_INVALID_BOARD;
+    }
+    let board = match load_board(slice::from_raw_parts(values, CELLS)) {
+        Ok(board) => board,
+        Err(result) => return result,
+    };
+
+    if !board.is_valid() {
+        SUDOKU_INVALID_BOARD
+    }
+    else if board.is_complete_board() {
+        SUDOKU_OK
+    }
+    else {
+        SUDOKU_INCOMPLETE
+    }
+}
@@ -0,0 +1,327 @@
+//! Runs the C solver (`c-impl`) and the Rust solver on the same puzzles and compares them
+//!
+//! Build the C programs first (`make solvesudoku timesolvesudoku` in `c-impl`), then run
+//!
+//!     cargo run --release --bin compare_solvers -- [--c-dir c-impl] [--engine name] [files...]
+//!
+//! Without files, every puzzle file in `samples/` is used. Files with one puzzle per line (81
+//! characters, `.` or `0` for empty tiles) are converted to the 9 line format both solvers read.
+//! Running everything takes several minutes, mostly in the Rust solver.
+//!
+//! Every solution must fill in the puzzle without changing its givens or repeating a value. It is
+//! also compared to the file of known solutions next to the puzzles (`<name>solutions.txt`) when
+//! there is one. Some puzzles have more than one solution, so a different solution is listed but
+//! not counted as wrong.
+//!
+//! The C times are the per puzzle times of `timesolvesudoku` and the Rust times are measured the
+//! same way: only solving, not reading the board. The report has the throughput of both solvers,
+//! the distribution of Rust/C latency ratios per file and the puzzles and files that make up most
+//! of the difference in total time. Exits with status 1 if either solver got a puzzle wrong.
+
+extern crate sudoku;
+
+mod timings;
+
+use std::cmp::Ordering;
+use std::env;
+use std::fs;
+use std::io::{self, Cursor, Read, Write};
+use std::path::{Path, PathBuf};
+use std::process::{self, Command, Stdio};
+use std::time::Instant;
+
+use sudoku::*;
+
+use timings::*;
+
+/// Files in samples/ that do not hold plain 9x9 puzzles
+const SKIPPED_SAMPLES: &[&str] = &["variants.txt"];
+/// The most puzzles listed as making up the difference between the solvers
+const MAX_LISTED: usize = 10;
+
+struct Options {
+    c_dir: PathBuf,
+    engine: Option<String>,
+    files: Vec<PathBuf>,
+}
+
+/// One puzzle and the results of both solvers on it
+struct Puzzle {
+    /// The puzzle in the 9 line format, 0 for empty tiles
+    text: String,
+    known_solution: Option<String>,
+    c_solution: Option<String>,
+    c_nanos: Option<f64>,
+    rust_solution: Option<String>,
+    rust_nanos: f64,
+}
+
+fn fail(message: String) -> ! {
+    eprintln!("{}", message);
+    process::exit(2);
+}
+
+/// Reads the puzzles of a file in either the 9 line or the single line format and returns them in
+/// the 9 line format
+fn read_puzzle_texts(path: &Path) -> Vec<String> {
+    let contents = fs::read_to_string(path)
+        .unwrap_or_else(|err| fail(format!("Unable to read {}: {}", path.display(), err)));
+    // Some of the single line files end with a DOS end of file character
+    let lines: Vec<&str> = contents.lines()
+        .map(|line| line.trim_end_matches(|c: char| c.is_whitespace() || c.is_control()))
+        .filter(|line| !line.is_empty())
+        .collect();
+
+    if lines.iter().all(|line| line.len() == 81) {
+        lines.iter().map(|line| {
+            let mut text = String::with_capacity(90);
+            for (i, c) in line.chars().enumerate() {
+                text.push(if c == '.' { '0' } else { c });
+                if i % 9 == 8 {
+                    text.push('\n');
+                }
+            }
+            text
+        }).collect()
+    }
+    else {
+        lines.chunks(9).map(|rows| rows.iter().map(|row| format!("{}\n", row)).collect()).collect()
+    }
+}
+
+/// Returns every puzzle file in the samples directory
+fn sample_files() -> Vec<PathBuf> {
+    let mut files: Vec<PathBuf> = fs::read_dir("samples")
+        .unwrap_or_else(|err| fail(format!("Unable to list samples/: {}", err)))
+        .filter_map(|entry| entry.ok().map(|entry| entry.path()))
+        .filter(|path| {
+            let name = path.file_name().and_then(|name| name.to_str()).unwrap_or("");
+            name.ends_with(".txt") && !name.ends_with("solutions.txt") && !SKIPPED_SAMPLES.contains(&name)
+        })
+        .collect();
+    files.sort();
+    files
+}
+
+/// Returns the file of known solutions of a puzzle file if it has one
+fn solutions_file(path: &Path) -> Option<PathBuf> {
+    let stem = path.file_stem()?.to_str()?;
+    let solutions = path.with_file_name(format!("{}solutions.txt", stem));
+    if solutions.exists() { Some(solutions) } else { None }
+}
+
+/// Runs a C program with the puzzles on stdin and returns its output
+fn run_c_program(options: &Options, program: &str, input: &str) -> String {
+    let path = options.c_dir.join(program);
+    let mut command = Command::new(&path);
+    if let Some(ref engine) = options.engine {
+        command.arg("--engine").arg(engine);
+    }
+    let mut child = command.stdin(Stdio::piped()).stdout(Stdio::piped()).stderr(Stdio::null()).spawn()
+        .unwrap_or_else(|err| fail(format!("Unable to run {} ({}). Build it with make in {}.",
+            path.display(), err, options.c_dir.display())));
+
+    // Write from another thread so that neither side blocks on a full pipe
+    let mut stdin = child.stdin.take().unwrap();
+    let input = input.to_string();
+    let writer = std::thread::spawn(move || stdin.write_all(input.as_bytes()));
+    let mut output = String::new();
+    child.stdout.take().unwrap().read_to_string(&mut output)
+        .unwrap_or_else(|err| fail(format!("Unable to read the output of {}: {}", path.display(), err)));
+    let _ = writer.join();
+    let _ = child.wait();
+    output
+}
+
+/// Splits the output of solvesudoku into one solution (or None for a puzzle it could not solve)
+/// per puzzle
+fn parse_c_solutions(output: &str) -> Vec<Option<String>> {
+    let mut solutions = Vec::new();
+    let mut lines = output.lines();
+    while let Some(line) = lines.next() {
+        if line.len() != 9 {
+            // "Invalid board." or "No solution found."
+            solutions.push(None);
+            continue;
+        }
+        let mut text = format!("{}\n", line);
+        for row in lines.by_ref().take(8) {
+            text.push_str(row);
+            text.push('\n');
+        }
+        solutions.push(Some(text));
+    }
+    solutions
+}
+
+/// Whether solution is a valid way to fill in the puzzle
+fn is_correct(puzzle: &Puzzle, solution: &Option<String>) -> bool {
+    let solution = match *solution {
+        Some(ref solution) => solution,
+        None => return false,
+    };
+    if puzzle.known_solution.as_ref() == Some(solution) {
+        return true;
+    }
+
+    let keeps_givens = puzzle.text.bytes().zip(solution.bytes())
+        .all(|(given, value)| given == b'0' || given == value);
+    match Sudoku::read_board(Cursor::new(solution.as_bytes())) {
+        Ok(board) => keeps_givens && board.is_complete_board() && board.is_valid(),
+        Err(_) => false,
+    }
+}
+
+fn solve_file(options: &Options, path: &Path) -> Vec<Puzzle> {
+    let texts = read_puzzle_texts(path);
+    let known: Vec<String> = solutions_file(path).map(|solutions| read_puzzle_texts(&solutions)).unwrap_or_default();
+    let input: String = texts.concat();
+
+    let c_solutions = parse_c_solutions(&run_c_program(options, "solvesudoku", &input));
+    let c_times = parse_timings(&run_c_program(options, "timesolvesudoku", &input)).unwrap_or_default();
+
+    texts.into_iter().enumerate().map(|(i, text)| {
+        let (rust_solution, rust_nanos) = match Sudoku::read_board(Cursor::new(text.as_bytes())) {
+            Ok(mut board) => {
+                let start = Instant::now();
+                let result = board.solve();
+                let elapsed = start.elapsed();
+                let nanos = elapsed.as_secs() as f64 * 1e9 + elapsed.subsec_nanos() as f64;
+                (result.ok().map(|_| board.to_string()), nanos)
+            },
+            Err(_) => (None, 0.0),
+        };
+
+        Puzzle {
+            text,
+            known_solution: known.get(i).cloned(),
+            c_solution: c_solutions.get(i).cloned().unwrap_or(None),
+            c_nanos: c_times.get(i).cloned().unwrap_or(None),
+            rust_solution,
+            rust_nanos,
+        }
+    }).collect()
+}
+
+/// Prints the results of one file and returns the number of wrong solutions
+fn report_file(name: &str, puzzles: &[Puzzle]) -> usize {
+    let c_wrong = puzzles.iter().filter(|p| !is_correct(p, &p.c_solution)).count();
+    let rust_wrong = puzzles.iter().filter(|p| !is_correct(p, &p.rust_solution)).count();
+    let timed: Vec<(f64, f64)> = puzzles.iter()
+        .filter_map(|p| p.c_nanos.map(|c| (c, p.rust_nanos)))
+        .filter(|&(c, rust)| c > 0.0 && rust > 0.0)
+        .collect();
+    let c_total: f64 = timed.iter().map(|&(c, _)| c).sum();
+    let rust_total: f64 = timed.iter().map(|&(_, rust)| rust).sum();
+
+    println!("{}: {} puzzles, {} wrong in C, {} wrong in Rust", name, puzzles.len(), c_wrong, rust_wrong);
+    let results = puzzles.iter().enumerate().flat_map(|(i, p)| {
+        vec![("C", &p.c_solution), ("Rust", &p.rust_solution)].into_iter().filter_map(move |(solver, solution)| {
+            if !is_correct(p, solution) {
+                Some(format!("    #{} is wrong in {}", i + 1, solver))
+            }
+            else if p.known_solution.is_some() && p.known_solution != *solution {
+                Some(format!("    #{} has a different (valid) solution in {}", i + 1, solver))
+            }
+            else {
+                None
+            }
+        })
+    });
+    for line in results.take(MAX_LISTED) {
+        println!("{}", line);
+    }
+    if !timed.is_empty() {
+        let mut ratios: Vec<f64> = timed.iter().map(|&(c, rust)| rust / c).collect();
+        sort_floats(&mut ratios);
+        println!("    total      C {:>12}  Rust {:>12}  Rust/C {:.2}x", format_time(c_total), format_time(rust_total), rust_total / c_total);
+        println!("    puzzles/s  C {:>12.0}  Rust {:>12.0}", timed.len() as f64 / c_total * 1e9, timed.len() as f64 / rust_total * 1e9);
+        println!("    Rust/C per puzzle: p10 {:.2}x  p50 {:.2}x  p90 {:.2}x  p99 {:.2}x  max {:.2}x",
+            percentile(&ratios, 0.1), percentile(&ratios, 0.5), percentile(&ratios, 0.9),
+            percentile(&ratios, 0.99), percentile(&ratios, 1.0));
+    }
+    c_wrong + rust_wrong
+}
+
+fn parse_options() -> Options {
+    let usage = || -> ! {
+        fail("Usage: compare_solvers [--c-dir path] [--engine name] [files...]".to_string());
+    };
+
+    let mut options = Options {c_dir: PathBuf::from("c-impl"), engine: None, files: Vec::new()};
+    let mut args = env::args().skip(1);
+    while let Some(arg) = args.next() {
+        match arg.as_str() {
+            "--c-dir" => options.c_dir = args.next().map(PathBuf::from).unwrap_or_else(|| usage()),
+            "--engine" => options.engine = Some(args.next().unwrap_or_else(|| usage())),
+            _ if arg.starts_with("--") => usage(),
+            _ => options.files.push(PathBuf::from(arg)),
+        }
+    }
+    if options.files.is_empty() {
+        options.files = sample_files();
+    }
+    options
+}
+
+fn main() {
+    let options = parse_options();
+
+    let mut wrong = 0;
+    // (file, puzzle number, C time, Rust time) of every puzzle both solvers were timed on
+    let mut gaps: Vec<(String, usize, f64, f64)> = Vec::new();
+    for path in &options.files {
+        let name = path.display().to_string();
+        eprintln!("Solving {}...", name);
+        let puzzles = solve_file(&options, path);
+        wrong += report_file(&name, &puzzles);
+        io::stdout().flush().unwrap();
+
+        for (i, puzzle) in puzzles.iter().enumerate() {
+            if let Some(c) = puzzle.c_nanos {
+                gaps.push((name.clone(), i + 1, c, puzzle.rust_nanos));
+            }
+        }
+    }
+
+    let c_total: f64 = gaps.iter().map(|g| g.2).sum();
+    let rust_total: f64 = gaps.iter().map(|g| g.3).sum();
+    let total_gap = rust_total - c_total;
+    println!();
+    if gaps.is_empty() {
+        println!("No puzzle was timed by both solvers");
+    }
+    else {
+        println!("All files: {} puzzles, C {} ({:.0} puzzles/s), Rust {} ({:.0} puzzles/s), Rust/C {:.2}x",
+            gaps.len(), format_time(c_total), gaps.len() as f64 / c_total * 1e9,
+            format_time(rust_total), gaps.len() as f64 / rust_total * 1e9, rust_total / c_total);
+    }
+
+    // Which files and puzzles the difference in total time comes from
+    if total_gap != 0.0 {
+        println!("Share of the difference in total time (Rust {} by {}):",
+            if total_gap > 0.0 { "slower" } else { "faster" }, format_time(total_gap.abs()));
+        for path in &options.files {
+            let name = path.display().to_string();
+            let gap: f64 = gaps.iter().filter(|g| g.0 == name).map(|g| g.3 - g.2).sum();
+            println!("    {:<32} {:>7.1}%", name, gap / total_gap * 100.0);
+        }
+
+        // Largest first in the direction of the total difference
+        gaps.sort_by(|a, b| ((b.3 - b.2) * total_gap.signum()).partial_cmp(&((a.3 - a.2) * total_gap.signum()))
+            .unwrap_or(Ordering::Equal));
+        let top = (gaps.len() + 99) / 100;
+        let top_gap: f64 = gaps.iter().take(top).map(|g| g.3 - g.2).sum();
+        println!("The {} puzzles (1%) with the largest difference make up {:.1}% of it:",
+            top, top_gap / total_gap * 100.0);
+        for &(ref name, puzzle, c, rust) in gaps.iter().take(MAX_LISTED) {
+            println!("    {} #{:<6} C {:>12}  Rust {:>12}  Rust/C {:.2}x", name, puzzle, format_time(c), format_time(rust), rust / c);
+        }
+    }
+
+    if wrong > 0 {
+        println!();
+        println!("{} wrong solutions", wrong);
+        process::exit(1);
+    }
+}
@@ -0,0 +1,206 @@
+//! Compares two timing CSVs (written by `timesolvesudoku` or `tests/timer.rs`) puzzle by puzzle
+//!
+//! Run with `cargo run --release --bin compare_timings -- before.csv after.csv`
+//!
+//! Puzzles are matched by their position in the files. The elapsed time is the last column of
+//! every row. A row without one (e.g. "Invalid board.") is a puzzle without a time, except for
+//! the "No solution found." row that follows the time of an unsolved puzzle: it is not a puzzle
+//! of its own and leaves that puzzle without a time. The report has the speedup of the whole set,
+//! how the distribution of times shifted, a Wilcoxon signed-rank test of whether the after times
+//! differ from the before times and the puzzles that got slower by more than the run to run noise.
+//!
+//! Exits with status 1 if the after times are significantly slower overall, so this can be used
+//! as a gate.
+
+mod timings;
+
+use std::cmp::Ordering;
+use std::env;
+use std::f64::consts::SQRT_2;
+use std::fs;
+use std::process;
+
+use timings::*;
+
+/// Default significance level of the signed-rank test
+const DEFAULT_ALPHA: f64 = 0.01;
+/// Default relative slowdown that is tolerated before anything counts as a regression
+const DEFAULT_THRESHOLD: f64 = 0.05;
+/// Puzzles are flagged if their slowdown is this many (robust) standard deviations above the
+/// typical change of a puzzle
+const NOISE_DEVIATIONS: f64 = 4.0;
+/// The most flagged puzzles that are listed
+const MAX_LISTED: usize = 20;
+
+struct Options {
+    before: String,
+    after: String,
+    alpha: f64,
+    threshold: f64,
+}
+
+/// The elapsed times of one CSV in nanoseconds, None for puzzles without a time or solution
+fn read_timings(path: &str) -> Vec<Option<f64>> {
+    let csv = fs::read_to_string(path).unwrap_or_else(|err| {
+        eprintln!("Unable to read {}: {}", path, err);
+        process::exit(2);
+    });
+    parse_timings(&csv).unwrap_or_else(|| {
+        eprintln!("{} is empty", path);
+        process::exit(2);
+    })
+}
+
+/// The complementary error function, accurate to about 1.2e-7 (Numerical Recipes' erfcc)
+fn erfc(x: f64) -> f64 {
+    let z = x.abs();
+    let t = 1.0 / (1.0 + 0.5 * z);
+    let polynomial = -z * z - 1.26551223 + t * (1.00002368 + t * (0.37409196 + t * (0.09678418
+        + t * (-0.18628806 + t * (0.27886807 + t * (-1.13520398 + t * (1.48851587
+        + t * (-0.82215223 + t * 0.17087277))))))));
+    let result = t * polynomial.exp();
+    if x >= 0.0 { result } else { 2.0 - result }
+}
+
+/// Wilcoxon signed-rank test of paired differences using the normal approximation (with
+/// corrections for ties and continuity), which is accurate for the thousands of puzzles in a
+/// timing run. Differences of zero are dropped.
+///
+/// Returns the z statistic (positive if the differences tend to be positive) and the two-sided
+/// p-value
+fn wilcoxon_signed_rank(differences: &[f64]) -> (f64, f64) {
+    let mut ranked: Vec<f64> = differences.iter().cloned().filter(|d| *d != 0.0).collect();
+    ranked.sort_by(|a, b| a.abs().partial_cmp(&b.abs()).unwrap_or(Ordering::Equal));
+    let n = ranked.len() as f64;
+    if ranked.is_empty() {
+        return (0.0, 1.0);
+    }
+
+    // Tied absolute differences all get the average of their ranks
+    let mut positive_ranks = 0.0;
+    let mut tie_correction = 0.0;
+    let mut start = 0;
+    while start < ranked.len() {
+        let mut end = start + 1;
+        while end < ranked.len() && ranked[end].abs() == ranked[start].abs() {
+            end += 1;
+        }
+        let rank = (start + end + 1) as f64 / 2.0;
+        positive_ranks += rank * ranked[start..end].iter().filter(|d| **d > 0.0).count() as f64;
+        let ties = (end - start) as f64;
+        tie_correction += ties * ties * ties - ties;
+        start = end;
+    }
+
+    let mean = n * (n + 1.0) / 4.0;
+    let variance = n * (n + 1.0) * (2.0 * n + 1.0) / 24.0 - tie_correction / 48.0;
+    if variance <= 0.0 {
+        return (0.0, 1.0);
+    }
+    let deviation = positive_ranks - mean;
+    let continuity = if deviation > 0.0 { -0.5 } else if deviation < 0.0 { 0.5 } else { 0.0 };
+    let z = (deviation + continuity) / variance.sqrt();
+    (z, erfc(z.abs() / SQRT_2))
+}
+
+fn parse_options() -> Options {
+    let usage = || -> ! {
+        eprintln!("Usage: compare_timings [--alpha p] [--threshold fraction] before.csv after.csv");
+        process::exit(2);
+    };
+
+    let mut alpha = DEFAULT_ALPHA;
+    let mut threshold = DEFAULT_THRESHOLD;
+    let mut paths = Vec::new();
+    let mut args = env::args().skip(1);
+    while let Some(arg) = args.next() {
+        match arg.as_str() {
+            "--alpha" => alpha = args.next().and_then(|p| p.parse().ok()).unwrap_or_else(|| usage()),
+            "--threshold" => threshold = args.next().and_then(|t| t.parse().ok()).unwrap_or_else(|| usage()),
+            _ => paths.push(arg),
+        }
+    }
+    if paths.len() != 2 {
+        usage();
+    }
+
+    let after = paths.pop().unwrap();
+    let before = paths.pop().unwrap();
+    Options {before, after, alpha, threshold}
+}
+
+fn main() {
+    let options = parse_options();
+    let before = read_timings(&options.before);
+    let after = read_timings(&options.after);
+
+    // (puzzle number, before, after) for every puzzle timed in both files
+    let pairs: Vec<(usize, f64, f64)> = before.iter().zip(&after).enumerate()
+        .filter_map(|(i, (b, a))| match (b, a) {
+            (&Some(b), &Some(a)) => Some((i + 1, b, a)),
+            _ => None,
+        })
+        .collect();
+    if pairs.is_empty() {
+        eprintln!("No puzzle was timed in both files");
+        process::exit(2);
+    }
+
+    println!("Puzzles: {} before, {} after, {} timed in both", before.len(), after.len(), pairs.len());
+
+    let total_before: f64 = pairs.iter().map(|&(_, b, _)| b).sum();
+    let total_after: f64 = pairs.iter().map(|&(_, _, a)| a).sum();
+    // Speedups are averaged on a log scale so that 2x faster and 2x slower cancel out
+    let log_ratios: Vec<f64> = pairs.iter().map(|&(_, b, a)| (a / b).ln()).collect();
+    let geometric_speedup = (-log_ratios.iter().sum::<f64>() / log_ratios.len() as f64).exp();
+    println!("Total time: {} before, {} after ({:.3}x speedup)",
+        format_time(total_before), format_time(total_after), total_before / total_after);
+    println!("Geometric mean speedup per puzzle: {:.3}x", geometric_speedup);
+
+    let mut sorted_before: Vec<f64> = pairs.iter().map(|&(_, b, _)| b).collect();
+    let mut sorted_after: Vec<f64> = pairs.iter().map(|&(_, _, a)| a).collect();
+    sort_floats(&mut sorted_before);
+    sort_floats(&mut sorted_after);
+    println!();
+    println!("{:>8} {:>14} {:>14} {:>10}", "", "before", "after", "speedup");
+    for &(name, fraction) in &[("min", 0.0), ("p50", 0.5), ("p90", 0.9), ("p99", 0.99), ("p99.9", 0.999), ("max", 1.0)] {
+        let b = percentile(&sorted_before, fraction);
+        let a = percentile(&sorted_after, fraction);
+        println!("{:>8} {:>14} {:>14} {:>9.3}x", name, format_time(b), format_time(a), b / a);
+    }
+
+    let (z, p) = wilcoxon_signed_rank(&log_ratios);
+    let direction = if z > 0.0 { "slower after" } else if z < 0.0 { "faster after" } else { "no change" };
+    println!();
+    println!("Wilcoxon signed-rank test: z = {:.2}, p = {:.3e} ({}, {})", z, p, direction,
+        if p < options.alpha { "significant" } else { "not significant" });
+
+    // The typical change of a puzzle and how much it varies (median absolute deviation, scaled to
+    // match a standard deviation) tell real regressions apart from noise
+    let mut sorted_ratios = log_ratios.clone();
+    sort_floats(&mut sorted_ratios);
+    let median_ratio = percentile(&sorted_ratios, 0.5);
+    let mut deviations: Vec<f64> = log_ratios.iter().map(|r| (r - median_ratio).abs()).collect();
+    sort_floats(&mut deviations);
+    let noise = 1.4826 * percentile(&deviations, 0.5);
+    let limit = (median_ratio + NOISE_DEVIATIONS * noise).max((1.0 + options.threshold).ln());
+
+    let mut regressions: Vec<&(usize, f64, f64)> = pairs.iter().zip(&log_ratios)
+        .filter(|&(_, ratio)| *ratio > limit)
+        .map(|(pair, _)| pair)
+        .collect();
+    regressions.sort_by(|x, y| (y.2 / y.1).partial_cmp(&(x.2 / x.1)).unwrap_or(Ordering::Equal));
+    println!("Puzzles slower by more than {:.1}% (beyond noise): {}", (limit.exp() - 1.0) * 100.0, regressions.len());
+    for &&(puzzle, b, a) in regressions.iter().take(MAX_LISTED) {
+        println!("  #{:<8} {:>14} -> {:>14} ({:.2}x slower)", puzzle, format_time(b), format_time(a), a / b);
+    }
+    if regressions.len() > MAX_LISTED {
+        println!("  ... and {} more", regressions.len() - MAX_LISTED);
+    }
+
+    if z > 0.0 && p < options.alpha && geometric_speedup < 1.0 / (1.0 + options.threshold) {
+        println!();
+        println!("REGRESSION: after is significantly slower than before");
+        process::exit(1);
+    }
+}
@@ -1,22 +1,90 @@
 extern crate sudoku;
 
-use std::io::stdin;
+use std::env;
+use std::io::{stdin, stdout, Write};
+use std::process;
 
 use sudoku::*;
 
-fn main() {
-    let stdin = stdin();
-    while let Ok(mut board) = Sudoku::read_board(stdin.lock()) {
-        if !board.is_valid() {
+/// The most boards read before they are solved and written out with --threads
+const BATCH_SIZE: usize = 4096;
+
+fn usage() -> ! {
+    eprintln!("Usage: solve [--threads n] < input");
+    process::exit(2);
+}
+
+/// Solves the boards read so far on the given number of threads and writes out their solutions
+/// in the order they were read. invalid has an entry for every board read, true if it was invalid
+/// (and not put in boards).
+fn solve_batch(boards: &mut Vec<Sudoku>, invalid: &mut Vec<bool>, threads: usize) {
+    let results = solve_all(boards, threads);
+
+    let stdout = stdout();
+    let mut stdout = stdout.lock();
+    let mut solved = boards.iter().zip(results);
+    for &is_invalid in invalid.iter() {
+        if is_invalid {
             eprintln!("Invalid board.");
             continue;
         }
 
-        if let Err(SolverError::NoSolution) = board.solve() {
-            eprintln!("No solution found.");
-            continue;
+        match solved.next() {
+            Some((board, Ok(()))) => write!(stdout, "{}", board).unwrap(),
+            _ => eprintln!("No solution found."),
         }
+    }
+    stdout.flush().unwrap();
 
-        print!("{}", board);
+    boards.clear();
+    invalid.clear();
+}
+
+fn main() {
+    let mut threads = None;
+    let mut args = env::args().skip(1);
+    while let Some(arg) = args.next() {
+        match arg.as_str() {
+            "--threads" => threads = Some(args.next().and_then(|n| n.parse().ok()).unwrap_or_else(|| usage())),
+            _ => usage(),
+        }
+    }
+
+    let stdin = stdin();
+    let mut reader = BoardReader::new(stdin.lock());
+    let threads = match threads {
+        Some(threads) => threads,
+        // Solve and write out every board as soon as it is read
+        None => {
+            while let Ok(Some(mut board)) = reader.read_board() {
+                if !board.is_valid() {
+                    eprintln!("Invalid board.");
+                    continue;
+                }
+
+                if let Err(SolverError::NoSolution) = board.solve() {
+                    eprintln!("No solution found.");
+                    continue;
+                }
+
+                print!("{}", board);
+            }
+            return;
+        },
+    };
+
+    let mut boards = Vec::with_capacity(BATCH_SIZE);
+    let mut invalid = Vec::with_capacity(BATCH_SIZE);
+    while let Ok(Some(board)) = reader.read_board() {
+        let is_invalid = !board.is_valid();
+        if !is_invalid {
+            boards.push(board);
+        }
+        invalid.push(is_invalid);
+
+        if invalid.len() == BATCH_SIZE {
+            solve_batch(&mut boards, &mut invalid, threads);
+        }
     }
+    solve_batch(&mut boards, &mut invalid, threads);
 }
@@ -0,0 +1,64 @@
+//! Reading the timing CSVs written by `timesolvesudoku` and `tests/timer.rs` and reporting times,
+//! shared by `compare_timings` and `compare_solvers`
+
+use std::cmp::Ordering;
+
+/// The row that timesolvesudoku writes after the time of a puzzle it could not solve
+const NO_SOLUTION: &str = "No solution found.";
+
+/// Returns the elapsed time (last column) of every puzzle of a timing CSV in nanoseconds, None
+/// for puzzles without a time (e.g. "Invalid board.") or without a solution. The "No solution
+/// found." row that follows the time of an unsolved puzzle is not a puzzle of its own.
+///
+/// Returns None if the CSV does not even have a header
+pub fn parse_timings(csv: &str) -> Option<Vec<Option<f64>>> {
+    let mut lines = csv.lines();
+    let header = lines.next()?;
+    // Old C timings were written in seconds, everything newer is in nanoseconds
+    let scale = if header.trim_end().ends_with("(s)") { 1e9 } else { 1.0 };
+
+    let mut timings = Vec::new();
+    for line in lines {
+        let line = line.trim_end();
+        if line == NO_SOLUTION {
+            if let Some(last) = timings.last_mut() {
+                *last = None;
+            }
+            continue;
+        }
+        timings.push(line.rsplit(',').next()
+            .and_then(|elapsed| elapsed.parse::<f64>().ok())
+            .filter(|elapsed| *elapsed > 0.0)
+            .map(|elapsed| elapsed * scale));
+    }
+    Some(timings)
+}
+
+/// Sorts a slice of floats that contains no NaNs
+pub fn sort_floats(values: &mut [f64]) {
+    values.sort_by(|a, b| a.partial_cmp(b).unwrap_or(Ordering::Equal));
+}
+
+/// Returns the value at the given fraction (0 to 1) of sorted values, interpolating between the
+/// values around it
+pub fn percentile(sorted: &[f64], fraction: f64) -> f64 {
+    let position = fraction * (sorted.len() - 1) as f64;
+    let lower = position.floor() as usize;
+    let upper = position.ceil() as usize;
+    sorted[lower] + (sorted[upper] - sorted[lower]) * (position - lower as f64)
+}
+
+pub fn format_time(nanoseconds: f64) -> String {
+    if nanoseconds >= 1e9 {
+        format!("{:.3} s", nanoseconds / 1e9)
+    }
+    else if nanoseconds >= 1e6 {
+        format!("{:.3} ms", nanoseconds / 1e6)
+    }
+    else if nanoseconds >= 1e3 {
+        format!("{:.3} us", nanoseconds / 1e3)
+    }
+    else {
+        format!("{:.0} ns", nanoseconds)
+    }
+}
@@ -1,5 +1,13 @@
 #![cfg_attr(not(feature = "std"), no_std)]
 
 mod sudoku;
+#[cfg(feature = "std")]
+mod parallel;
+#[cfg(feature = "std")]
+mod reader;
 
 pub use sudoku::*;
+#[cfg(feature = "std")]
+pub use parallel::*;
+#[cfg(feature = "std")]
+pub use reader::*;
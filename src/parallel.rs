@@ -0,0 +1,64 @@
+use std::sync::Mutex;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::thread;
+
+use sudoku::{Sudoku, SolverError};
+
+/// The number of boards a thread takes at a time
+///
+/// Some boards take thousands of times longer than others, so threads take small chunks and come
+/// back for more instead of splitting the boards evenly up front. A chunk is still large enough
+/// that taking it is cheap next to solving it.
+const CHUNK_SIZE: usize = 16;
+
+/// Solves every board in place using the given number of threads (0 uses one for every CPU)
+///
+/// Returns the result of solving each board, in the same order as the boards. Boards that could
+/// not be solved are left unchanged.
+pub fn solve_all(boards: &mut [Sudoku], threads: usize) -> Vec<Result<(), SolverError>> {
+    let threads = if threads == 0 {
+        thread::available_parallelism().map(|count| count.get()).unwrap_or(1)
+    }
+    else {
+        threads
+    };
+    let mut results = vec![Ok(()); boards.len()];
+
+    let chunk_count = (boards.len() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    let threads = threads.min(chunk_count);
+    if threads <= 1 {
+        for (board, result) in boards.iter_mut().zip(&mut results) {
+            *result = board.solve();
+        }
+        return results;
+    }
+
+    // Every chunk is taken by exactly one thread, so its lock is never waited on. The counter
+    // hands out the next chunk that nobody has taken yet.
+    let chunks: Vec<Mutex<(&mut [Sudoku], &mut [Result<(), SolverError>])>> = boards.chunks_mut(CHUNK_SIZE)
+        .zip(results.chunks_mut(CHUNK_SIZE))
+        .map(Mutex::new)
+        .collect();
+    let next_chunk = AtomicUsize::new(0);
+
+    thread::scope(|scope| {
+        for _ in 0..threads {
+            scope.spawn(|| {
+                loop {
+                    let chunk_i = next_chunk.fetch_add(1, Ordering::Relaxed);
+                    let mut chunk = match chunks.get(chunk_i) {
+                        Some(chunk) => chunk.lock().unwrap(),
+                        None => break,
+                    };
+                    let (ref mut boards, ref mut results) = *chunk;
+                    for (board, result) in boards.iter_mut().zip(results.iter_mut()) {
+                        *result = board.solve();
+                    }
+                }
+            });
+        }
+    });
+    drop(chunks);
+
+    results
+}
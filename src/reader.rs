@@ -0,0 +1,263 @@
+use std::io::{self, Read};
+
+use sudoku::{Sudoku, ReadError};
+
+// The width and height of the board
+const BOARD_SIZE: usize = 9;
+// The number of tiles of a board
+const CELLS: usize = BOARD_SIZE * BOARD_SIZE;
+// The number of bytes of a board written on BOARD_SIZE lines, including their newlines
+const GRID_TEXT_SIZE: usize = BOARD_SIZE * (BOARD_SIZE + 1);
+// The number of bytes of a board written on a single line, including its newline
+const LINE_TEXT_SIZE: usize = CELLS + 1;
+// The number of bytes read at a time
+const BUFFER_SIZE: usize = 1 << 20;
+// Zeroed bytes kept after the end of the buffered text so that whole words can be read past the
+// end of a board
+const BUFFER_SLACK: usize = 128;
+
+// The number of 8 byte words that cover the text of a board in either format
+const TEXT_WORDS: usize = 12;
+// A byte in every byte of a word
+const ONES: u64 = 0x0101010101010101;
+const HIGH_BITS: u64 = 0x80 * ONES;
+
+/// Returns one 0xFF byte for every byte of the text of a board (as words) that is a digit in the
+/// format of BOARD_SIZE lines (or a newline if newlines is true)
+const fn grid_masks(newlines: bool) -> [u64; TEXT_WORDS] {
+    let mut masks = [0; TEXT_WORDS];
+    let mut i = 0;
+    while i < GRID_TEXT_SIZE {
+        if (i % (BOARD_SIZE + 1) == BOARD_SIZE) == newlines {
+            masks[i / 8] |= 0xFF << (i % 8 * 8);
+        }
+        i += 1;
+    }
+    masks
+}
+
+/// Returns one 0xFF byte for every byte of the text of a board (as words) that is a tile in the
+/// single line format
+const fn line_masks() -> [u64; TEXT_WORDS] {
+    let mut masks = [0; TEXT_WORDS];
+    let mut i = 0;
+    while i < CELLS {
+        masks[i / 8] |= 0xFF << (i % 8 * 8);
+        i += 1;
+    }
+    masks
+}
+
+const GRID_DIGITS: [u64; TEXT_WORDS] = grid_masks(false);
+const GRID_NEWLINES: [u64; TEXT_WORDS] = grid_masks(true);
+const LINE_DIGITS: [u64; TEXT_WORDS] = line_masks();
+
+fn load_word(text: &[u8], word_i: usize) -> u64 {
+    let mut bytes = [0; 8];
+    bytes.copy_from_slice(&text[word_i * 8..word_i * 8 + 8]);
+    u64::from_le_bytes(bytes)
+}
+
+/// Returns a word with the high bit set in every byte of word that is zero
+fn zero_bytes(word: u64) -> u64 {
+    // Adding 0x7F to the low bits of a byte sets its high bit unless they are all zero and can
+    // never carry into the next byte
+    !(((word & !HIGH_BITS) + !HIGH_BITS) | word) & HIGH_BITS
+}
+
+/// Returns a word that is not zero in every byte of word that is not an ASCII digit
+fn non_digit_bytes(word: u64) -> u64 {
+    // Digits are 0x30 to 0x39, so their high half is 3 and stays 3 when 6 is added. Adding 6 can
+    // only carry out of a byte that is not a digit, which already makes the result non-zero.
+    ((word & (0xF0 * ONES)) ^ (0x30 * ONES)) | ((word.wrapping_add(0x06 * ONES) & (0xF0 * ONES)) ^ (0x30 * ONES))
+}
+
+/// Converts the digit bytes of word selected by digits to their values and every other byte to 0
+fn digit_values(word: u64, digits: u64) -> u64 {
+    // Other bytes are replaced by '0' first so that nothing is borrowed from the next byte
+    ((word & digits) | ((b'0' as u64 * ONES) & !digits)).wrapping_sub(b'0' as u64 * ONES)
+}
+
+/// Returns the index of the first newline in the first length bytes of text, reading whole words
+/// (up to 7 bytes past them)
+fn find_newline(text: &[u8], length: usize) -> Option<usize> {
+    for word_i in 0..(length + 7) / 8 {
+        let newlines = zero_bytes(load_word(text, word_i) ^ (b'\n' as u64 * ONES));
+        if newlines != 0 {
+            let index = word_i * 8 + newlines.trailing_zeros() as usize / 8;
+            return if index < length { Some(index) } else { None };
+        }
+    }
+    None
+}
+
+/// Finds the first byte of the text of a board that is not valid where it is, for a more useful
+/// error than "somewhere in this board"
+fn find_error(text: &[u8], length: usize, newline_at: impl Fn(usize) -> bool, allow_dots: bool) -> ReadError {
+    for (i, &c) in text[..length].iter().enumerate() {
+        if newline_at(i) {
+            if c != b'\n' {
+                return ReadError::ExpectedNewline;
+            }
+        }
+        else if !c.is_ascii_digit() && !(allow_dots && c == b'.') {
+            return ReadError::InvalidDigit(c as char);
+        }
+    }
+    ReadError::ExpectedNewline
+}
+
+/// Converts the text of a board written on BOARD_SIZE lines into values, 8 bytes at a time
+fn parse_grid_text(text: &[u8], values: &mut [u8; CELLS]) -> Result<(), ReadError> {
+    let mut digits = [0; TEXT_WORDS * 8];
+    let mut invalid = 0;
+    for word_i in 0..TEXT_WORDS {
+        let word = load_word(text, word_i);
+        invalid |= non_digit_bytes(word) & GRID_DIGITS[word_i];
+        invalid |= (word ^ (b'\n' as u64 * ONES)) & GRID_NEWLINES[word_i];
+        digits[word_i * 8..word_i * 8 + 8].copy_from_slice(&digit_values(word, GRID_DIGITS[word_i]).to_le_bytes());
+    }
+    if invalid != 0 {
+        return Err(find_error(text, GRID_TEXT_SIZE, |i| i % (BOARD_SIZE + 1) == BOARD_SIZE, false));
+    }
+
+    for (row, line) in values.chunks_mut(BOARD_SIZE).zip(digits.chunks(BOARD_SIZE + 1)) {
+        row.copy_from_slice(&line[..BOARD_SIZE]);
+    }
+    Ok(())
+}
+
+/// Converts the text of a board written on a single line (with 0 or '.' for empty tiles) into
+/// values, 8 bytes at a time
+fn parse_line_text(text: &[u8], values: &mut [u8; CELLS]) -> Result<(), ReadError> {
+    let mut digits = [0; TEXT_WORDS * 8];
+    let mut invalid = 0;
+    for word_i in 0..TEXT_WORDS {
+        let mut word = load_word(text, word_i);
+        // Dots become '0' ('.' + 2), which cannot carry into the next byte
+        let dots = zero_bytes(word ^ (b'.' as u64 * ONES)) >> 7;
+        word += dots * 2;
+        invalid |= non_digit_bytes(word) & LINE_DIGITS[word_i];
+        digits[word_i * 8..word_i * 8 + 8].copy_from_slice(&digit_values(word, LINE_DIGITS[word_i]).to_le_bytes());
+    }
+    if invalid != 0 {
+        return Err(find_error(text, LINE_TEXT_SIZE, |i| i == CELLS, true));
+    }
+
+    values.copy_from_slice(&digits[..CELLS]);
+    Ok(())
+}
+
+/// Reads boards from a reader through a large buffer instead of a few bytes at a time
+///
+/// Two formats are read, and they can be mixed:
+///
+/// * 9 lines of 9 digits, the format read by `Sudoku::read_board`
+/// * A single line of 81 digits, where empty tiles can also be written as `.`
+///
+/// The length of the first line tells them apart. Whole boards are checked and converted with a
+/// few operations on 8 bytes at a time instead of byte by byte. The reader is only read from when
+/// the rest of a board has not arrived yet, so boards are returned as soon as they can be.
+pub struct BoardReader<R> {
+    reader: R,
+    /// Bytes read but not parsed yet are buffer[start..end]
+    buffer: Vec<u8>,
+    start: usize,
+    end: usize,
+    end_of_file: bool,
+}
+
+impl<R: Read> BoardReader<R> {
+    pub fn new(reader: R) -> Self {
+        BoardReader {
+            reader,
+            // Room for a newline added after the last line as well
+            buffer: vec![0; BUFFER_SIZE + 1 + BUFFER_SLACK],
+            start: 0,
+            end: 0,
+            end_of_file: false,
+        }
+    }
+
+    /// Moves the bytes that have not been parsed yet to the front of the buffer and reads more
+    /// of them. At the end of the input, a newline is added after the last line if it does not
+    /// have one.
+    fn fill_buffer(&mut self) -> io::Result<()> {
+        self.buffer.copy_within(self.start..self.end, 0);
+        self.end -= self.start;
+        self.start = 0;
+
+        let size = loop {
+            match self.reader.read(&mut self.buffer[self.end..BUFFER_SIZE]) {
+                Err(ref err) if err.kind() == io::ErrorKind::Interrupted => continue,
+                result => break result?,
+            }
+        };
+        self.end += size;
+        if size == 0 {
+            self.end_of_file = true;
+            if self.end > 0 && self.buffer[self.end - 1] != b'\n' {
+                self.buffer[self.end] = b'\n';
+                self.end += 1;
+            }
+        }
+        for byte in &mut self.buffer[self.end..self.end + BUFFER_SLACK] {
+            *byte = 0;
+        }
+        Ok(())
+    }
+
+    /// Reads the values of the next board into values (0 for empty tiles)
+    ///
+    /// Returns false if there are no more boards
+    pub fn read_values(&mut self, values: &mut [u8; CELLS]) -> Result<bool, ReadError> {
+        loop {
+            let available = self.end - self.start;
+            if available == 0 && self.end_of_file {
+                return Ok(false);
+            }
+
+            let text = &self.buffer[self.start..];
+            let line_length = find_newline(text, available.min(LINE_TEXT_SIZE));
+            match line_length {
+                Some(BOARD_SIZE) if available >= GRID_TEXT_SIZE => {
+                    parse_grid_text(text, values)?;
+                    self.start += GRID_TEXT_SIZE;
+                    return Ok(true);
+                },
+                Some(CELLS) => {
+                    parse_line_text(text, values)?;
+                    self.start += LINE_TEXT_SIZE;
+                    return Ok(true);
+                },
+                _ => {},
+            }
+
+            // Only read more if the rest of the board may still arrive
+            let incomplete = match line_length {
+                Some(length) => length == BOARD_SIZE,
+                None => available < LINE_TEXT_SIZE,
+            };
+            if !incomplete {
+                return Err(ReadError::ExpectedNewline);
+            }
+            if self.end_of_file {
+                return Err(ReadError::IOError(io::ErrorKind::UnexpectedEof.into()));
+            }
+            self.fill_buffer().map_err(ReadError::IOError)?;
+        }
+    }
+
+    /// Reads the next board
+    ///
+    /// Returns None if there are no more boards
+    pub fn read_board(&mut self) -> Result<Option<Sudoku>, ReadError> {
+        let mut values = [0; CELLS];
+        if self.read_values(&mut values)? {
+            Ok(Some(Sudoku::from_values(&values)))
+        }
+        else {
+            Ok(None)
+        }
+    }
+}
@@ -166,11 +166,51 @@ impl Sudoku {
         Ok(board)
     }
 
+    /// Creates a board from the value of every tile, stored row by row with 0 for empty tiles
+    ///
+    /// Panics if a value is greater than 9
+    pub fn from_values(values: &[u8; BOARD_SIZE * BOARD_SIZE]) -> Self {
+        let mut board = Self::default();
+        for (i, &value) in values.iter().enumerate() {
+            if let Some(value) = NonZeroU8::new(value) {
+                board.place(Pos {row: i / BOARD_SIZE, col: i % BOARD_SIZE}, value);
+            }
+        }
+        board
+    }
+
     /// Returns true if the board is a valid sudoku board
     /// A board is invalid if there are duplicate numbers in any row, column, or box
     /// or if any of its values are out of the range 0 to BOARD_SIZE inclusive.
     pub fn is_valid(&self) -> bool {
-        true // TODO
+        // One bit per value for every row, column and box. A bit that is already set when a
+        // value is added to its unit means that the value is repeated.
+        let mut rows = [0u16; BOARD_SIZE];
+        let mut cols = [0u16; BOARD_SIZE];
+        let mut boxes = [0u16; BOARD_SIZE];
+
+        for (row_i, row) in self.tiles.iter().enumerate() {
+            for (col_i, tile) in row.iter().enumerate() {
+                let value = match tile.value {
+                    Some(value) => value.get() as usize,
+                    None => continue,
+                };
+                if value > BOARD_SIZE {
+                    return false;
+                }
+
+                let bit = 1 << (value - 1);
+                let box_i = (row_i / BOX_SIZE) * BOX_SIZE + col_i / BOX_SIZE;
+                if (rows[row_i] | cols[col_i] | boxes[box_i]) & bit != 0 {
+                    return false;
+                }
+                rows[row_i] |= bit;
+                cols[col_i] |= bit;
+                boxes[box_i] |= bit;
+            }
+        }
+
+        true
     }
 
     /// Returns true if the board is completely filled
@@ -178,6 +218,11 @@ impl Sudoku {
         self.empty_tiles == 0
     }
 
+    /// Returns the value of the tile at the given position or None if it is empty
+    pub fn value(&self, Pos {row, col}: Pos) -> Option<NonZeroU8> {
+        self.tiles[row][col].value
+    }
+
     /// Provides a rating of the difficulty of a puzzle based on how many empty tiles there are
     pub fn difficulty(&self) -> f64 {
         1.0 - self.empty_tiles as f64 / (BOARD_SIZE*BOARD_SIZE) as f64
@@ -269,8 +314,10 @@ impl Sudoku {
         Err(SolverError::NoSolution)
     }
 
-    // Returns the tile with the minimum number of possibilities
-    fn min_possible_empty_tile(&self) -> Result<Pos, SolverError> {
+    /// Returns the empty tile with the minimum number of possibilities
+    ///
+    /// Fails if the board has no empty tiles
+    pub fn min_possible_empty_tile(&self) -> Result<Pos, SolverError> {
         let mut min = Err(SolverError::NoSolution);
 
         for (row_i, row) in self.tiles.iter().enumerate() {
@@ -13,6 +13,8 @@ macro_rules! test_and_check {
             match (test_set.next(), solutions.next()) {
                 (Some(mut test_board), Some(solution)) => {
                     assert!(solution.is_complete_board(), "Solution was not a solution for #{}\n{}\n", i, solution);
+                    assert!(solution.is_valid(), "Solution for #{} has repeated values\n{}\n", i, solution);
+                    assert!(test_board.is_valid(), "Test board #{} has repeated values\n{}\n", i, test_board);
 
                     println!("Testing board #{}...", i);
 
@@ -40,6 +42,66 @@ fn hard95() {
     test_and_check!("../samples/hard95.txt" => "../samples/hard95solutions.txt");
 }
 
+#[test]
+fn hard95_solve_all() {
+    let mut test_set: Vec<Sudoku> = read_all_boards(include_bytes!("../samples/hard95.txt")).collect();
+    let solutions: Vec<Sudoku> = read_all_boards(include_bytes!("../samples/hard95solutions.txt")).collect();
+
+    // More threads than this machine probably has, so that the threads take turns with chunks
+    let results = solve_all(&mut test_set, 4);
+    for (i, ((result, board), solution)) in results.iter().zip(&test_set).zip(&solutions).enumerate() {
+        assert!(result.is_ok(), "Unable to solve #{}", i + 1);
+        assert_eq!(board, solution, "\n#{} did not result in the correct solution\nExpected Solution:\n{}\nActual Solution:\n{}\n", i + 1, solution, board);
+    }
+}
+
+#[test]
+fn board_reader_formats() {
+    // The reader of the library, not the one of these tests
+    use sudoku::BoardReader;
+
+    // top95 has the same puzzles as hard95, written on single lines with dots for empty tiles
+    let boards: Vec<Sudoku> = read_all_boards(include_bytes!("../samples/hard95.txt")).collect();
+    let mut lines = BoardReader::new(Cursor::new(&include_bytes!("../samples/top95.txt")[..]));
+    let mut grids = BoardReader::new(Cursor::new(&include_bytes!("../samples/hard95.txt")[..]));
+    for (i, board) in boards.iter().enumerate() {
+        assert_eq!(lines.read_board().unwrap().as_ref(), Some(board), "Single line board #{} was read incorrectly", i + 1);
+        assert_eq!(grids.read_board().unwrap().as_ref(), Some(board), "Board #{} was read incorrectly", i + 1);
+    }
+    assert!(grids.read_board().unwrap().is_none());
+
+    // Both formats in the same input, without a final newline
+    let mixed = format!("{}{}", boards[0], &include_str!("../samples/top95.txt")[82..163]);
+    let mut reader = BoardReader::new(Cursor::new(mixed.as_bytes()));
+    assert_eq!(reader.read_board().unwrap().as_ref(), Some(&boards[0]));
+    assert_eq!(reader.read_board().unwrap().as_ref(), Some(&boards[1]));
+    assert!(reader.read_board().unwrap().is_none());
+
+    let invalid: [&[u8]; 4] = [
+        b"0000x0000\n000000000\n000000000\n000000000\n000000000\n000000000\n000000000\n000000000\n000000000\n",
+        b"000.00000\n000000000\n000000000\n000000000\n000000000\n000000000\n000000000\n000000000\n000000000\n",
+        b"000000000\n0000000000\n00000000\n000000000\n000000000\n000000000\n000000000\n000000000\n000000000\n",
+        b"000000000\n000000000\n",
+    ];
+    for text in &invalid {
+        assert!(BoardReader::new(Cursor::new(*text)).read_board().is_err(), "Should not read:\n{}", String::from_utf8_lossy(text));
+    }
+}
+
+#[test]
+fn invalid_boards() {
+    // The same value twice in a row, a column and a box
+    let boards: [&[u8]; 3] = [
+        b"110000000\n000000000\n000000000\n000000000\n000000000\n000000000\n000000000\n000000000\n000000000\n",
+        b"500000000\n000000000\n000000000\n000000000\n000000000\n000000000\n000000000\n000000000\n500000000\n",
+        b"000000000\n000000000\n000000000\n000000000\n000090000\n000009000\n000000000\n000000000\n000000000\n",
+    ];
+    for board in &boards {
+        let board = Sudoku::read_board(Cursor::new(*board)).unwrap();
+        assert!(!board.is_valid(), "Board should be invalid:\n{}\n", board);
+    }
+}
+
 fn read_all_boards(data: &'static [u8]) -> impl Iterator<Item=Sudoku> {
     // FIXME: Eventually when Rust supports `yield`, this could be rewritten without the extra struct
     let reader = Cursor::new(data);